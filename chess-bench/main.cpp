@@ -0,0 +1,355 @@
+#include "chess-simulator.h"
+#include "mcts-evaluator-impl.h"
+#include "nnue.h"
+#include "playout-policy.h"
+#include "chess.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Positions the benchmarks run from: opening, middlegame and endgame
+static const std::vector<std::string> benchFens = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+// Positions with a clear best move (any of the listed ones) for the tactics benchmark
+struct BenchTactic {
+    std::string fen;
+    std::vector<std::string> bestMoves;
+};
+
+static const std::vector<BenchTactic> tacticPositions = {
+    {"6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", {"a1a8"}},
+    {"3r2k1/8/8/8/8/8/5PPP/6K1 b - - 0 1", {"d8d1"}},
+    {"k7/8/1K6/8/8/8/8/7Q w - - 0 1", {"h1h8", "h1b7"}},
+    {"q3k3/8/8/1N6/8/8/8/4K3 w - - 0 1", {"b5c7"}},
+    {"4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1", {"d2d5"}},
+    {"8/P6k/8/8/8/8/8/K7 w - - 0 1", {"a7a8q"}},
+};
+
+// Play random games to the end with a playout policy and
+// report playouts/sec and the cost of each ply
+static void benchPlayouts(ChessSimulator::MCTS_Playout policy, const char *name, int playouts) {
+    std::mt19937 rng(1234);
+    long long plies = 0;
+
+    auto beforeTime = std::chrono::high_resolution_clock::now();
+    for (auto const &fen : benchFens) {
+        for (int i = 0; i < playouts; i++) {
+            chess::Board board(fen);
+            while (board.isGameOver().first == chess::GameResultReason::NONE) {
+                chess::Movelist moves;
+                chess::movegen::legalmoves(moves, board);
+                board.makeMove(ChessSimulator::pickPlayoutMove(board, moves, policy, 100.0f, rng));
+                plies++;
+            }
+        }
+    }
+    auto afterTime = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+    int games = playouts * (int)benchFens.size();
+    std::printf("playout %-8s %8d games %10lld plies %10.1f playouts/s %8.1f ns/ply %6.1f plies/game\n", name, games, plies,
+                games / seconds, seconds * 1e9 / plies, (double)plies / games);
+}
+
+// Time NNUE evaluations, both rebuilding the accumulators from scratch
+// and the incremental make/evaluate/unmake path the search uses
+static void benchNnue(const std::string &weightsPath, int rounds) {
+    ChessSimulator::NNUE_Network network;
+    if (weightsPath.empty() || !network.load(weightsPath)) {
+        network.randomize(1234);
+    }
+    ChessSimulator::NNUE_Evaluator evaluator(network);
+
+    long long evals = 0;
+    long long checksum = 0;
+    auto beforeTime = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (auto const &fen : benchFens) {
+            chess::Board board(fen);
+            evaluator.refresh(board);
+            checksum += evaluator.evaluate(board);
+            evals++;
+        }
+    }
+    auto afterTime = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+    std::printf("nnue refresh     %10lld evals %12.1f evals/s\n", evals, evals / seconds);
+
+    evals = 0;
+    beforeTime = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (auto const &fen : benchFens) {
+            chess::Board board(fen);
+            evaluator.refresh(board);
+            chess::Movelist moves;
+            chess::movegen::legalmoves(moves, board);
+            for (auto const &move : moves) {
+                evaluator.makeMove(board, move);
+                checksum += evaluator.evaluate(board);
+                evaluator.unmakeMove(board, move);
+                evals++;
+            }
+        }
+    }
+    afterTime = std::chrono::high_resolution_clock::now();
+    seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+    std::printf("nnue incremental %10lld evals %12.1f evals/s (checksum %lld)\n", evals, evals / seconds, checksum);
+}
+
+// Search with NNUE leaves valued one at a time, then queued and valued in batches
+// of several sizes, and report the leaves valued per second
+static void benchBatch(const std::string &weightsPath, int cycles) {
+    ChessSimulator::NNUE_Network network;
+    if (weightsPath.empty() || !network.load(weightsPath)) {
+        network.randomize(1234);
+    }
+    ChessSimulator::NNUE_BatchEvaluator batchEvaluator(network);
+
+    double baseRate = 0;
+    for (int batchSize : {0, 8, 32, 128}) {
+        ChessSimulator::MCTS_Settings settings;
+        settings.treeSize = std::max(ChessSimulator::MCTS_TREE_SIZE, 2 * 64 * (cycles + 1));
+        settings.network = &network;
+        settings.leafEval = ChessSimulator::MCTS_LeafEval::NNUE;
+        if (batchSize > 0) {
+            settings.leafEval = ChessSimulator::MCTS_LeafEval::BATCH;
+            settings.batchEvaluator = &batchEvaluator;
+            settings.batchSize = batchSize;
+        }
+
+        // Every leaf backed up passes through the root once
+        long long leaves = 0;
+        auto beforeTime = std::chrono::high_resolution_clock::now();
+        for (auto const &fen : benchFens) {
+            auto evaluator = std::make_unique<ChessSimulator::MCTS_Evaluator>(chess::Board(fen), cycles, 1234, settings);
+            evaluator->genMove();
+            for (auto const &stat : evaluator->getRootStats()) {
+                leaves += stat.visits + 1;
+            }
+        }
+        auto afterTime = std::chrono::high_resolution_clock::now();
+
+        double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+        double rate = leaves / seconds;
+        if (batchSize == 0) {
+            baseRate = rate;
+        }
+        std::printf("batch %-7s %4d leaves/batch %10lld leaves %12.1f leaves/s %5.2fx\n", batchSize ? "batched" : "serial",
+                    batchSize, leaves, rate, rate / baseRate);
+    }
+}
+
+// Run the same searches with 1, 2, 4... playout threads and compare
+// their playout throughput against a single thread
+static void benchLeafParallel(int cycles, int playoutsPerChild) {
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    double baseRate = 0;
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        ChessSimulator::MCTS_Settings settings;
+        settings.threads = threads;
+        settings.playoutsPerChild = playoutsPerChild;
+
+        long long playouts = 0;
+        auto beforeTime = std::chrono::high_resolution_clock::now();
+        for (auto const &fen : benchFens) {
+            auto evaluator = std::make_unique<ChessSimulator::MCTS_Evaluator>(chess::Board(fen), cycles, 1234, settings);
+            evaluator->genMove();
+            playouts += evaluator->getPlayouts();
+        }
+        auto afterTime = std::chrono::high_resolution_clock::now();
+
+        double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+        double rate = playouts / seconds;
+        if (threads == 1) {
+            baseRate = rate;
+        }
+        std::printf("leaf-parallel %3d threads %10lld playouts %10.1f playouts/s %5.2fx\n", threads, playouts, rate,
+                    rate / baseRate);
+    }
+}
+
+// Search configurations fixed at compile time, next to the run time default
+using namespace ChessSimulator;
+using UCTUniform = MCTS_BasicEvaluator<MCTS_Policies<MCTS_UCTSelection<>, MCTS_FullExpansion, MCTS_UniformPlayout,
+                                                     MCTS_FixedLeafEval<MCTS_LeafEval::PLAYOUT>>>;
+using PUCTHeavy = MCTS_BasicEvaluator<MCTS_Policies<MCTS_PUCTSelection<1.5f>, MCTS_FullExpansion, MCTS_HeavyPlayout<100.0f>,
+                                                    MCTS_FixedLeafEval<MCTS_LeafEval::PLAYOUT>>>;
+using NarrowStatic = MCTS_BasicEvaluator<MCTS_Policies<MCTS_PUCTSelection<2.0f>, MCTS_WidthExpansion<8>, MCTS_UniformPlayout,
+                                                       MCTS_FixedLeafEval<MCTS_LeafEval::STATIC>, MCTS_DiscountedBackup<0.99f>>>;
+
+// Run the same searches with one evaluator build and report cycles/sec
+template <typename Evaluator> static void benchPolicy(const char *name, int cycles) {
+    long long playouts = 0;
+    std::string moves;
+    auto beforeTime = std::chrono::high_resolution_clock::now();
+    for (auto const &fen : benchFens) {
+        auto evaluator = std::make_unique<Evaluator>(chess::Board(fen), cycles, 1234, MCTS_Settings());
+        moves += " " + chess::uci::moveToUci(evaluator->genMove());
+        playouts += evaluator->getPlayouts();
+    }
+    auto afterTime = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+    int searches = benchFens.size();
+    std::printf("policy %-14s %8.1f cycles/s %10.1f playouts/s  moves%s\n", name, searches * cycles / seconds,
+                playouts / seconds, moves.c_str());
+}
+
+// Search every tactic with a few seeds under one configuration and count how
+// often the search finds a best move
+static void benchTactics(const ChessSimulator::MCTS_Settings &settings, const char *name, int cycles, int seeds) {
+    int hits = 0;
+    auto beforeTime = std::chrono::high_resolution_clock::now();
+    for (auto const &tactic : tacticPositions) {
+        for (int seed = 0; seed < seeds; seed++) {
+            auto evaluator =
+                std::make_unique<ChessSimulator::MCTS_Evaluator>(chess::Board(tactic.fen), cycles, 1234 + seed, settings);
+            std::string move = chess::uci::moveToUci(evaluator->genMove());
+            if (std::find(tactic.bestMoves.begin(), tactic.bestMoves.end(), move) != tactic.bestMoves.end()) {
+                hits++;
+            }
+        }
+    }
+    auto afterTime = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+    int searches = tacticPositions.size() * seeds;
+    std::printf("tactics %-8s %4d/%-4d best moves %5.1f%% %8.1f cycles/s\n", name, hits, searches, 100.0 * hits / searches,
+                searches * cycles / seconds);
+}
+
+// Run the same searches without and with a trace recorder and report
+// what recording every cycle costs
+static void benchTrace(const std::string &path, int cycles) {
+    double baseRate = 0;
+    for (int traced = 0; traced < 2; traced++) {
+        std::unique_ptr<ChessSimulator::MCTS_TraceRecorder> recorder;
+        ChessSimulator::MCTS_Settings settings;
+        if (traced) {
+            recorder = std::make_unique<ChessSimulator::MCTS_TraceRecorder>(path);
+            settings.trace = recorder.get();
+        }
+
+        auto beforeTime = std::chrono::high_resolution_clock::now();
+        for (auto const &fen : benchFens) {
+            auto evaluator = std::make_unique<ChessSimulator::MCTS_Evaluator>(chess::Board(fen), cycles, 1234, settings);
+            evaluator->genMove();
+        }
+        auto afterTime = std::chrono::high_resolution_clock::now();
+
+        double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+        double rate = benchFens.size() * cycles / seconds;
+        if (!traced) {
+            baseRate = rate;
+        }
+        std::printf("trace %-4s %10.1f cycles/s %+6.2f%%\n", traced ? "on" : "off", rate, 100.0 * (rate / baseRate - 1));
+    }
+}
+
+// Run static-evaluation searches without caches, then twice through the same
+// caches to show the hit rates within a search and across searches
+static void benchEvalCache(int cycles, int megabytes) {
+    ChessSimulator::EvalCache evalCache;
+    ChessSimulator::EvalCache pawnCache;
+    evalCache.resize((std::size_t)megabytes << 20);
+    pawnCache.resize((std::size_t)megabytes << 17);
+
+    for (int pass = 0; pass < 3; pass++) {
+        ChessSimulator::MCTS_Settings settings;
+        settings.leafEval = ChessSimulator::MCTS_LeafEval::STATIC;
+        if (pass > 0) {
+            settings.evalCache = &evalCache;
+            settings.pawnCache = &pawnCache;
+        }
+
+        std::uint64_t evalProbes = evalCache.getProbes(), evalHits = evalCache.getHits();
+        std::uint64_t pawnProbes = pawnCache.getProbes(), pawnHits = pawnCache.getHits();
+
+        auto beforeTime = std::chrono::high_resolution_clock::now();
+        for (auto const &fen : benchFens) {
+            auto evaluator = std::make_unique<ChessSimulator::MCTS_Evaluator>(chess::Board(fen), cycles, 1234, settings);
+            evaluator->genMove();
+        }
+        auto afterTime = std::chrono::high_resolution_clock::now();
+
+        // Hit rates of this pass alone
+        evalProbes = evalCache.getProbes() - evalProbes;
+        evalHits = evalCache.getHits() - evalHits;
+        pawnProbes = pawnCache.getProbes() - pawnProbes;
+        pawnHits = pawnCache.getHits() - pawnHits;
+
+        double seconds = std::chrono::duration<double>(afterTime - beforeTime).count();
+        const char *name = pass == 0 ? "uncached" : pass == 1 ? "cold" : "warm";
+        std::printf("eval-cache %-8s %10.1f cycles/s  eval hits %5.1f%%  pawn hits %5.1f%%\n", name,
+                    benchFens.size() * cycles / seconds, evalProbes ? 100.0 * evalHits / evalProbes : 0.0,
+                    pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "all";
+    int count = argc > 2 ? std::stoi(argv[2]) : 200;
+
+    if (mode == "all" || mode == "playouts") {
+        benchPlayouts(ChessSimulator::MCTS_Playout::UNIFORM, "uniform", count);
+        benchPlayouts(ChessSimulator::MCTS_Playout::HEAVY, "heavy", count);
+    }
+
+    if (mode == "all" || mode == "nnue") {
+        benchNnue(argc > 3 ? argv[3] : "", count * 50);
+    }
+
+    if (mode == "all" || mode == "batch") {
+        benchBatch(argc > 3 ? argv[3] : "", count);
+    }
+
+    if (mode == "all" || mode == "leafparallel") {
+        benchLeafParallel(count / 20 + 1, 4);
+    }
+
+    if (mode == "all" || mode == "evalcache") {
+        benchEvalCache(count, 16);
+    }
+
+    if (mode == "all" || mode == "trace") {
+        benchTrace(argc > 3 ? argv[3] : "chessbench.trace", count);
+    }
+
+    if (mode == "all" || mode == "tactics") {
+        ChessSimulator::MCTS_Settings settings;
+        benchTactics(settings, "uct", count, 4);
+        settings.selection = ChessSimulator::MCTS_Selection::PUCT;
+        benchTactics(settings, "puct", count, 4);
+    }
+
+    // RAVE on and off, with serial playouts and with playouts spread over a pool
+    if (mode == "all" || mode == "rave") {
+        ChessSimulator::MCTS_Settings settings;
+        benchTactics(settings, "uct", count, 4);
+        settings.rave = true;
+        benchTactics(settings, "rave", count, 4);
+        settings.threads = 4;
+        settings.playoutsPerChild = 2;
+        benchTactics(settings, "rave-4t", count, 4);
+    }
+
+    if (mode == "all" || mode == "policies") {
+        benchPolicy<MCTS_Evaluator>("settings", count);
+        benchPolicy<UCTUniform>("uct-uniform", count);
+        benchPolicy<PUCTHeavy>("puct-heavy", count);
+        benchPolicy<NarrowStatic>("narrow-static", count);
+    }
+
+    return 0;
+}
@@ -2,321 +2,219 @@
 // disservin's lib. drop a star on his hard work!
 // https://github.com/Disservin/chess-library
 #include "chess.hpp"
+#include "endgame-bitbase.h"
+#include "mcts-evaluator-impl.h"
+#include "opening-book.h"
+#include <algorithm>
+#include <cmath>
 #include <random>
 using namespace ChessSimulator;
 
-std::string ChessSimulator::Move(std::string fen)
-{
-	std::string moveStr;
+namespace {
+	OpeningBook& openingBook()
+	{
+		static OpeningBook book;
+		return book;
+	}
 
-	chess::Board iniBoard(fen);
+	EndgameBitbases& endgameBitbases()
+	{
+		static EndgameBitbases bitbases;
+		return bitbases;
+	}
 
-	MCTS_Evaluator boardEval(iniBoard, 10);
-	chess::Move move = boardEval.genMove();
-	moveStr = chess::uci::moveToUci(move);
+	EvalCache& evalCache()
+	{
+		static EvalCache cache;
+		return cache;
+	}
 
-	return moveStr;
+	EvalCache& pawnCache()
+	{
+		static EvalCache cache;
+		return cache;
+	}
 }
 
-MCTS_Evaluator::MCTS_Evaluator(chess::Board root, int depth)
+void ChessSimulator::InitEvalCache(std::size_t megabytes)
 {
-	m_RootBoard = root;
-	m_Cycles = depth;
+	// Pawn skeletons repeat far more often than positions, so they need less room
+	std::size_t bytes = megabytes << 20;
+	evalCache().resize(bytes - bytes / 8);
+	pawnCache().resize(bytes / 8);
 }
 
-MCTS_Evaluator::~MCTS_Evaluator()
+const EvalCache& ChessSimulator::GetEvalCache()
 {
+	return evalCache();
+}
 
+const EvalCache& ChessSimulator::GetPawnCache()
+{
+	return pawnCache();
 }
 
-chess::Move MCTS_Evaluator::genMove()
+MCTS_Settings ChessSimulator::WithProcessTables(const MCTS_Settings& settings)
 {
-	// Init root tree node
-	MCTS_Node& rootNode = m_StatTree[0];
-	rootNode.parentIndex = -1;
-	rootNode.visits = 0;
-	rootNode.simReward = 0;
-	m_FreeIndex++;
-	m_SimBoard = m_RootBoard;
-	rollout(0);
-	for (int i = 0; i < m_StatTree[0].childIndices.size(); i++)
+	MCTS_Settings tableSettings = settings;
+	if (!tableSettings.bitbases && endgameBitbases().isReady())
 	{
-		float simResult = simulation(m_StatTree[0].childIndices[i]);
-		update(m_StatTree[0].childIndices[i], simResult);
+		tableSettings.bitbases = &endgameBitbases();
 	}
 
-	// Do MCTS cycles based on the tree resolution
-	// specified by the class.
-	int currentCycle = m_Cycles;
-	while (currentCycle >= 0)
+	if (!tableSettings.evalCache && evalCache().isReady())
 	{
-		cycle();
-		currentCycle--;
+		tableSettings.evalCache = &evalCache();
 	}
 
-	// Check each child node of the root node
-	// to find the one with the most visits
-	int bestIndex = 1;
-	for (auto const index : rootNode.childIndices)
+	if (!tableSettings.pawnCache && pawnCache().isReady())
 	{
-		if (m_StatTree[index].simReward > m_StatTree[bestIndex].simReward)
-		{
-			bestIndex = index;
-		}
+		tableSettings.pawnCache = &pawnCache();
 	}
 
-	// Return the move used to reach the node
-	// with the most visits
-	return m_StatTree[bestIndex].move;
+	return tableSettings;
 }
 
-void MCTS_Evaluator::cycle()
+bool ChessSimulator::InitEndgameBitbases(const std::string& path)
 {
-	// Reset the sim board to the root board state
-	m_SimBoard = m_RootBoard;
-
-	// Get the index of the node we're going to expand this cycle
-	int expandedNodeIndex = selection(0);
-
-	// Get a leaf node to rollout and simulate from the expanded node
-	int leafNodeIndex = expansion(expandedNodeIndex);
-
-	// Generate all possible moves for the given leaf node
-	// This makes the node no longer a leaf
-	rollout(leafNodeIndex);
+	if (!path.empty() && endgameBitbases().load(path))
+	{
+		return true;
+	}
 
-	// For each newly generated leaf node, simulate a random game
-	// and backpropagate the results up to the root.
-	for (int i = 0; i < m_StatTree[leafNodeIndex].childIndices.size(); i++)
+	endgameBitbases().generate();
+	if (!path.empty())
 	{
-		float simResult = simulation(m_StatTree[leafNodeIndex].childIndices[i]);
-		update(m_StatTree[leafNodeIndex].childIndices[i], simResult);
+		return endgameBitbases().save(path);
 	}
+
+	return true;
 }
 
-// Select the index of the highest UCT
-int MCTS_Evaluator::selection(int nodeIndex)
+bool ChessSimulator::LoadOpeningBook(const std::string& path)
 {
-	// Select the child node with the highest
-	// UCT from the root game state to expand from
-	MCTS_Node& node = m_StatTree[nodeIndex];
-	int bestIndex = node.childIndices[0];
-	float bestVal = genUCT(m_StatTree[bestIndex]);
-	
-	for (int i = 1; i < node.childIndices.size(); i++)
+	if (path.empty())
 	{
-		int currentIndex = node.childIndices[i];
-		float currentVal = genUCT(m_StatTree[currentIndex]);
-
-		if (currentVal > bestVal)
-		{
-			bestIndex = currentIndex;
-			bestVal = currentVal;
-		}
-
+		openingBook().close();
+		return true;
 	}
 
-	// Update the SimBoard to reflect the move
-	// made by the given node
-	m_SimBoard.makeMove(m_StatTree[bestIndex].move);
-	return bestIndex;
+	return openingBook().open(path);
 }
 
-// Find the leaf node with the best UCT from a given node
-int MCTS_Evaluator::expansion(int nodeIndex)
+std::string ChessSimulator::Move(std::string fen)
 {
-	// Traverse through each of this node's
-	// child nodes until a leaf node is found
-	int currentIndex = nodeIndex;
-	while (m_StatTree[currentIndex].childIndices.size() != 0)
-	{
-		// Pick the child node with the highest UCT
-		currentIndex = selection(currentIndex);
-	}
+	// Callers handing over a FEN every move still get to reuse the
+	// tree when the new position follows on from the last one
+	thread_local Session session;
+	session.setPosition(chess::Board(fen));
 
-	return currentIndex;
+	return chess::uci::moveToUci(session.genMove());
 }
 
-// Generate all possible moves for a leaf node and add them as children
-void MCTS_Evaluator::rollout(int leafIndex)
+Session::Session()
+	: Session(chess::Board())
 {
-	// Generate all moves for the current leaf
-	// Won't work if SimBoard wasn't properly updated
-	// by the selection function's process.
-	MCTS_Node& expandedNode = m_StatTree[leafIndex];
-	expandedNode.childIndices.clear();
+}
 
-	chess::Movelist moves;
-	chess::movegen::legalmoves(moves, m_SimBoard);
+Session::Session(const chess::Board& board)
+	: Session(board, 10, MCTS_Settings())
+{
+}
 
-	// For each possible move
-	for (auto const& move : moves)
-	{
-		// Gen new node using unused node from stat tree
-		int newNodeIndex = m_FreeIndex;
-		MCTS_Node& newNode = m_StatTree[newNodeIndex];
-		m_FreeIndex++;
-
-		newNode.parentIndex = leafIndex;
-		newNode.childIndices.clear();
-		newNode.move = move;
-		newNode.visits = 0;
-		newNode.simReward = 0;
-
-		expandedNode.childIndices.push_back(newNodeIndex);
-	}
+Session::Session(const chess::Board& board, int depth, const MCTS_Settings& settings)
+	: m_BookRng(std::random_device{}())
+{
+	m_Board = board;
+	m_Settings = settings;
+	m_Evaluator = std::make_unique<MCTS_Evaluator>(board, depth, std::random_device()(), WithProcessTables(settings));
 }
 
-// Simulate from the leaf's state and return the endgame result
-float MCTS_Evaluator::simulation(int leafIndex)
+Session::~Session()
 {
-	chess::Board leafBoard = m_SimBoard;
-	leafBoard.makeMove(m_StatTree[leafIndex].move);
 
-	std::random_device rand;
-	std::mt19937 gen(rand());
+}
+
+chess::Move Session::genMove()
+{
+	return genMove(std::stop_token());
+}
 
-	// Simulate a random game until an end state is hit
-	bool endState = false;
-	while (!endState)
+chess::Move Session::genMove(std::stop_token stop)
+{
+	// Known positions are answered from the book without searching
+	if (openingBook().isOpen())
 	{
-		chess::Movelist moves;
-		chess::movegen::legalmoves(moves, leafBoard);
-		if (leafBoard.isGameOver().first != chess::GameResultReason::NONE)
+		chess::Move bookMove = openingBook().probe(m_Board, m_BookRng);
+		if (bookMove != chess::Move(chess::Move::NO_MOVE))
 		{
-			endState = true; continue;
+			return bookMove;
 		}
-
-		std::uniform_int_distribution<> moveRange(0, moves.size() - 1);
-		int moveID = moveRange(gen);
-		leafBoard.makeMove(moves[moveID]);
 	}
 
-	// Get the value of the simulation's end state
-	float simResult = 0;
+	// Bitbases and caches set up since the last search are used from this one on
+	MCTS_Settings tables = WithProcessTables(m_Settings);
+	m_Evaluator->setTables(tables.bitbases, tables.evalCache, tables.pawnCache);
 
+	return m_Evaluator->genMove(stop);
+}
+
+void Session::makeMove(chess::Move move)
+{
+	m_Board.makeMove(move);
+	m_Evaluator->advanceRoot(move);
+}
 
-	if (leafBoard.isGameOver().second == chess::GameResult::LOSE)
+void Session::setPosition(const chess::Board& board)
+{
+	if (board.hash() == m_Board.hash())
 	{
-		if (leafBoard.sideToMove() == m_RootBoard.sideToMove())
-		{
-			simResult = -1;
-		}
+		return;
+	}
 
-		else if (leafBoard.sideToMove() != m_RootBoard.sideToMove())
+	// Look for the position one and two plies on, which is
+	// where it'll be after our move and the reply to it
+	chess::Movelist moves;
+	chess::movegen::legalmoves(moves, m_Board);
+	for (auto const& move : moves)
+	{
+		chess::Board next = m_Board;
+		next.makeMove(move);
+		if (next.hash() == board.hash())
 		{
-			simResult = 1;
+			makeMove(move);
+			return;
 		}
-	}
 
-	else if (leafBoard.isGameOver().second == chess::GameResult::DRAW)
-	{
-		//simResult = genStateVal(leafBoard);
-		
-		if (m_RootBoard.sideToMove() == chess::Color::BLACK)
+		chess::Movelist replies;
+		chess::movegen::legalmoves(replies, next);
+		for (auto const& reply : replies)
 		{
-			//simResult *= -1;
+			next.makeMove(reply);
+			bool found = next.hash() == board.hash();
+			next.unmakeMove(reply);
+
+			if (found)
+			{
+				makeMove(move);
+				makeMove(reply);
+				return;
+			}
 		}
 	}
 
-	return simResult;
+	m_Board = board;
+	m_Evaluator->setRoot(board);
 }
 
-// Backpropagate up the tree from a node until the root is hit
-void MCTS_Evaluator::update(int nodeIndex, float simResult)
+const chess::Board& Session::getBoard() const
 {
-	int currentIndex = nodeIndex;
-	//m_StatTree[nodeIndex].visits++;
-	
-	// Backtrack up the tree until the root is hit
-	// (ie. a node w/o a parent)
-	while (currentIndex != -1)
-	{
-		// Update node visit count and sim result
-		m_StatTree[currentIndex].simReward += simResult;
-
-		// Update current node to parent node
-		int parentIndex = m_StatTree[currentIndex].parentIndex;
-		currentIndex = parentIndex;
-		m_StatTree[currentIndex].visits++; // is this wrong?
-	}
+	return m_Board;
 }
 
-float MCTS_Evaluator::genUCT(MCTS_Node node)
+MCTS_Evaluator& Session::getEvaluator()
 {
-	float value = 0;
-
-	float visits = node.visits + 0.0001;
-	float parentVisits = m_StatTree[node.parentIndex].visits + 0.0001;
-
-	float exploit = (node.simReward) / visits;
-	float expansion = sqrt(log(parentVisits) / visits);
-	value = exploit + (sqrt(2) * expansion);
-
-	return value;
+	return *m_Evaluator;
 }
 
-float MCTS_Evaluator::genStateVal(chess::Board board)
-{
-	std::string boardFen = board.getFen();
-	float val = 0;
-
-	for (int i = 0; i < boardFen.size(); i++)
-	{
-		switch (boardFen[i])
-		{
-			case 'k':
-				val -= 2500;
-				break;
-
-			case 'K':
-				val += 2500;
-				break;
-
-			case 'q':
-				val -= 1000;
-				break;
-
-			case 'Q':
-				val += 1000;
-				break;
-
-			case 'b':
-				val -= 350;
-				break;
-
-			case 'B':
-				val += 350;
-				break;
-
-			case 'n':
-				val -= 350;
-				break;
-
-			case 'N':
-				val += 350;
-				break;
-
-			case 'r':
-				val -= 500;
-				break;
-
-			case 'R':
-				val += 500;
-				break;
-
-			case 'p':
-				val -= 100;
-				break;
-
-			case 'P':
-				val += 100;
-				break;
-
-			default:
-				break;
-		}
-	}
-	val /= (6700 / 2);
-	return val;
-}
\ No newline at end of file
+template class ChessSimulator::MCTS_BasicEvaluator<>;
\ No newline at end of file
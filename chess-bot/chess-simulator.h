@@ -1,6 +1,19 @@
 #pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stop_token>
 #include <string>
+#include <utility>
+#include <vector>
 #include "chess.hpp"
+#include "mcts-policies.h"
+#include "mcts-types.h"
+#include "nnue.h"
+#include "tree-snapshot.h"
+#include "worker-pool.h"
 
 namespace ChessSimulator {
 	/**
@@ -11,6 +24,42 @@ namespace ChessSimulator {
 	 */
 	std::string Move(std::string fen);
 
+	/**
+	 * @brief Use a Polyglot opening book in Move before searching
+	 *
+	 * @param path The .bin book file, an empty path stops using the book
+	 * @return bool Whether the book could be opened
+	 */
+	bool LoadOpeningBook(const std::string& path);
+
+	/**
+	 * @brief Use endgame bitbases in Move, loading them from a file or generating them
+	 *
+	 * @param path File to load the bitbases from, they're generated and saved there
+	 * when it's missing. With an empty path they're only generated.
+	 * @return bool Whether the bitbases could be loaded or saved
+	 */
+	bool InitEndgameBitbases(const std::string& path);
+
+	/**
+	 * @brief Cache leaf evaluations and pawn structure terms across every search in the process
+	 *
+	 * @param megabytes Memory for both caches, nothing stops caching
+	 */
+	void InitEvalCache(std::size_t megabytes);
+
+	// The caches set up by InitEvalCache, for their statistics
+	const EvalCache& GetEvalCache();
+	const EvalCache& GetPawnCache();
+
+	/**
+	 * @brief Point settings at the bitbases and caches set up for the process
+	 *
+	 * @param settings Search settings, tables they already name are kept
+	 * @return MCTS_Settings The settings with the process-wide tables filled in
+	 */
+	MCTS_Settings WithProcessTables(const MCTS_Settings& settings);
+
 	/*
 	* MCTS Notes
 	* 
@@ -57,39 +106,192 @@ namespace ChessSimulator {
 	*	- Total visits
 	*/
 
-	struct MCTS_Node
-	{
-		chess::Move move;
-		int parentIndex = -1;
-		std::vector<int> childIndices;
-
-		int visits = 0;
-		float simReward = 0;
-	};
-
-	class MCTS_Evaluator
+	/*
+	* The MCTS search, built from compile-time policies (see mcts-policies.h).
+	*
+	* - MCTS_Evaluator is the default build, which takes every choice from MCTS_Settings.
+	*	Other builds fix choices and parameters in the type and skip the run time checks.
+	* - Member definitions live in mcts-evaluator-impl.h. MCTS_Evaluator is compiled once
+	*	in chess-simulator.cpp, other builds include the implementation where they're used.
+	*/
+	template <typename Policies = MCTS_Policies<>>
+	class MCTS_BasicEvaluator
 	{
 	public:
-		MCTS_Evaluator(chess::Board root, int depth);
-		~MCTS_Evaluator();
+		using SelectionPolicy = typename Policies::SelectionPolicy;
+		using ExpansionPolicy = typename Policies::ExpansionPolicy;
+		using PlayoutPolicy = typename Policies::PlayoutPolicy;
+		using LeafEvalPolicy = typename Policies::LeafEvalPolicy;
+		using BackupPolicy = typename Policies::BackupPolicy;
+
+		MCTS_BasicEvaluator(chess::Board root, int depth);
+		MCTS_BasicEvaluator(chess::Board root, int depth, std::uint32_t seed);
+		MCTS_BasicEvaluator(chess::Board root, int depth, std::uint32_t seed, const MCTS_Settings& settings);
+		~MCTS_BasicEvaluator();
 
 		chess::Move genMove();
+		// Search until the cycle budget is spent or a stop is requested, whichever comes
+		// first, and return the best move so far. A stop is noticed within one playout or
+		// leaf evaluation (one batch with BATCH leaf evaluation), children left unvalued
+		// by it keep no statistics. A negative depth searches until the stop.
+		// Once the tree is full (see isTreeFull) cycles value existing leaves again
+		// rather than growing it, so size treeSize for long searches.
+		chess::Move genMove(std::stop_token stop);
+
+		// Playouts run so far
+		std::int64_t getPlayouts() const;
+		// Whether the tree ran out of nodes during the last genMove()
+		bool isTreeFull() const;
+
+		// Statistics of every root child from the last genMove() call
+		std::vector<MCTS_RootStat> getRootStats() const;
+
+		// The best count root moves with their principal variations, best first
+		std::vector<MCTS_PVLine> getPVLines(int count) const;
+
+		// Write the search tree to a snapshot file
+		bool saveSnapshot(const std::string& path) const;
+		// Start the next genMove() from a snapshot of the same root position
+		// instead of an empty tree. Nodes beyond the tree's capacity are dropped.
+		// A damaged snapshot is rejected and leaves the evaluator with an empty tree.
+		bool loadSnapshot(const MCTS_TreeSnapshot& snapshot);
+
+		// Search a new root position from an empty tree on the next genMove()
+		void setRoot(const chess::Board& root);
+		// Use other bitbases and caches from the next genMove() on. The tree keeps
+		// its values, so they should agree with the old ones where both know a position.
+		void setTables(const EndgameBitbases* bitbases, EvalCache* evalCache, EvalCache* pawnCache);
+		// Play a move from the root, keeping the subtree under it for the next
+		// genMove(). Returns false when the move wasn't expanded and the tree was cleared.
+		bool advanceRoot(chess::Move move);
 
 	private:
 		void cycle();
+		int batchCycle(int maxExpansions);
+		void queueChildren(int nodeIndex);
+		void queueLeaf(int leafIndex);
+		void flushBatch();
+		void applyVirtualLoss(int nodeIndex, int sign);
 		int selection(int nodeIndex);
 		int expansion(int nodeIndex);
+		void backupSolved(int nodeIndex);
+		void seekSimBoard(int nodeIndex);
 		void rollout(int leafIndex);
+		void simulateChildren(int nodeIndex);
+		void revisitLeaf(int leafIndex);
 		float simulation(int leafIndex);
+		float playout(chess::Board& board, std::mt19937& rng, std::vector<std::uint16_t>* moves, int* plies = nullptr) const;
+		void addAmafMoves(const std::vector<std::uint16_t>& moves, int ply);
+		float networkValue(int leafIndex);
+		float genResultVal(const chess::Board& board) const;
+		// Value of a finished game or a bitbase position. proven is set for finished
+		// games, the only values the solver may prove nodes from.
+		bool genExactVal(const chess::Board& board, float& simResult, bool* proven = nullptr) const;
+		float genBitbaseVal(const chess::Board& board, BitbaseResult result) const;
+		void proveExact(int leafIndex, float simResult);
 		void update(int nodeIndex, float simResult);
-		float genUCT(MCTS_Node node);
-		float genStateVal(chess::Board board);
+		void updateAmaf(int nodeIndex, float simResult);
+		void prove(int nodeIndex, MCTS_Proof proof);
+		MCTS_Proof genParentProof(int nodeIndex);
+		int bestRootChild();
+		void reportAnalysis();
+		void reportProgress();
+		float genSelectionVal(const MCTS_Node& node);
+		void genPriors(int nodeIndex);
+		float genStateVal(const chess::Board& board) const;
 
 		chess::Board m_RootBoard;
+		// Board of the node at m_SimIndex, moved between nodes with make/unmake (see seekSimBoard)
 		chess::Board m_SimBoard;
+		int m_SimIndex = 0;
+		std::vector<chess::Move> m_SeekMoves;
 		int m_Cycles = 0;
+		std::mt19937 m_Rng;
+		MCTS_Settings m_Settings;
+
+		// Moves played since the root in the last simulation, and the
+		// moves of the last playout in the order they were played
+		MCTS_AmafMoves m_AmafMoves;
+		std::vector<std::uint16_t> m_PlayoutMoves;
+
+		// NNUE accumulators, kept in step with SimBoard while children are valued
+		std::unique_ptr<NNUE_Evaluator> m_Nnue;
+		std::uint64_t m_NnueHash = 0;
+
+		EvalWeights m_EvalWeights;
+		// Cache key salts of the static evaluation and the network
+		std::uint64_t m_StaticSalt = 0;
+		std::uint64_t m_NetworkSalt = 0;
 
-		MCTS_Node m_StatTree[10000];
+		// Leaves waiting on the batch evaluator and scratch space for their values
+		std::vector<int> m_BatchNodes;
+		std::vector<chess::Board> m_BatchBoards;
+		std::vector<float> m_BatchValues;
+
+		// Leaf parallel playouts: the pool, a generator and playout board per worker and
+		// scratch space for tasks. Serial playouts use the first worker's board.
+		std::unique_ptr<MCTS_WorkerPool> m_Pool;
+		std::vector<std::mt19937> m_WorkerRngs;
+		std::vector<chess::Board> m_WorkerBoards;
+		std::vector<int> m_TaskNodes;
+		std::vector<float> m_TaskResults;
+		std::vector<std::vector<std::uint16_t>> m_TaskMoves;
+		std::int64_t m_Playouts = 0;
+
+		// Scratch space choosing and renumbering the nodes kept by advanceRoot()
+		std::vector<int> m_RemapIndices;
+		std::vector<std::pair<int, int>> m_KeepQueue;
+
+		std::vector<MCTS_Node> m_StatTree;
 		int m_FreeIndex = 0;
+		bool m_WarmStart = false;
+		bool m_TreeFull = false;
+		std::uint32_t m_CycleCount = 0;
+
+		// The running genMove() call: its stop request, start and the counters progress is reported from
+		std::stop_token m_Stop;
+		std::chrono::steady_clock::time_point m_SearchStart;
+		std::int64_t m_SearchPlayouts = 0;
+		int m_SearchCycles = 0;
+	};
+
+	using MCTS_Evaluator = MCTS_BasicEvaluator<>;
+	extern template class MCTS_BasicEvaluator<>;
+
+	/*
+	* A game searched move by move. The session keeps the position, the
+	* evaluator and its tree between calls, so callers that already follow
+	* the game pass only the moves played and each search starts from the
+	* part of the last tree that's still reachable. Each search picks up the
+	* bitbases and caches the process has set up by then (see WithProcessTables).
+	*/
+	class Session
+	{
+	public:
+		Session();
+		explicit Session(const chess::Board& board);
+		Session(const chess::Board& board, int depth, const MCTS_Settings& settings);
+		~Session();
+
+		// Pick a move for the side to move, from the opening book when it knows the position
+		chess::Move genMove();
+		// Same, with a search that can be stopped early (see MCTS_BasicEvaluator::genMove)
+		chess::Move genMove(std::stop_token stop);
+
+		// Play a move on the session's board
+		void makeMove(chess::Move move);
+
+		// Jump to another position. Positions a move or two on from
+		// the current one are reached through makeMove() and keep the tree.
+		void setPosition(const chess::Board& board);
+
+		const chess::Board& getBoard() const;
+		MCTS_Evaluator& getEvaluator();
+
+	private:
+		chess::Board m_Board;
+		MCTS_Settings m_Settings;
+		std::mt19937 m_BookRng;
+		std::unique_ptr<MCTS_Evaluator> m_Evaluator;
 	};
 }
\ No newline at end of file
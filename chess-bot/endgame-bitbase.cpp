@@ -0,0 +1,313 @@
+#include "endgame-bitbase.h"
+#include <fstream>
+
+using namespace ChessSimulator;
+
+namespace {
+	enum Table
+	{
+		KPK,
+		KRK,
+		KQK,
+		TABLE_COUNT
+	};
+
+	constexpr std::uint32_t kMagic = 0x53414242; // "BBAS"
+	constexpr std::uint32_t kVersion = 1;
+
+	// Stronger side to move or not, both kings and the piece
+	constexpr int kPositions = 2 * 64 * 64 * 64;
+	constexpr int kWords = kPositions / 64;
+
+	enum PositionState : std::uint8_t
+	{
+		UNKNOWN,
+		WON,
+		INVALID
+	};
+
+	int bitbaseIndex(int weakToMove, int strongKing, int weakKing, int piece)
+	{
+		return ((weakToMove * 64 + strongKing) * 64 + weakKing) * 64 + piece;
+	}
+
+	chess::Bitboard squareBB(int square)
+	{
+		return chess::Bitboard(1ULL << square);
+	}
+
+	bool adjacent(int a, int b)
+	{
+		int fileDistance = (a & 7) > (b & 7) ? (a & 7) - (b & 7) : (b & 7) - (a & 7);
+		int rankDistance = (a >> 3) > (b >> 3) ? (a >> 3) - (b >> 3) : (b >> 3) - (a >> 3);
+		return fileDistance <= 1 && rankDistance <= 1;
+	}
+
+	// Squares the stronger side's piece attacks, the pawn moving up the board
+	chess::Bitboard pieceAttacks(chess::PieceType type, int square, chess::Bitboard occupied)
+	{
+		if (type == chess::PieceType::PAWN)
+		{
+			return chess::attacks::pawn(chess::Color::WHITE, chess::Square(square));
+		}
+
+		if (type == chess::PieceType::ROOK)
+		{
+			return chess::attacks::rook(chess::Square(square), occupied);
+		}
+
+		return chess::attacks::queen(chess::Square(square), occupied);
+	}
+}
+
+void EndgameBitbases::generate()
+{
+	// Promotions look up the piece tables, so they go first
+	generateTable(KQK, chess::PieceType::QUEEN);
+	generateTable(KRK, chess::PieceType::ROOK);
+	generateTable(KPK, chess::PieceType::PAWN);
+	m_Ready = true;
+}
+
+void EndgameBitbases::generateTable(int table, chess::PieceType type)
+{
+	std::vector<std::uint8_t> states(kPositions, UNKNOWN);
+	bool isPawn = type == chess::PieceType::PAWN;
+
+	// Mark positions that can't occur, and checkmates
+	for (int index = 0; index < kPositions; index++)
+	{
+		int piece = index & 63;
+		int weakKing = (index >> 6) & 63;
+		int strongKing = (index >> 12) & 63;
+		int weakToMove = index >> 18;
+
+		if (strongKing == weakKing || strongKing == piece || weakKing == piece || adjacent(strongKing, weakKing) ||
+			(isPawn && (piece < 8 || piece >= 56)))
+		{
+			states[index] = INVALID;
+			continue;
+		}
+
+		chess::Bitboard occupied = squareBB(strongKing) | squareBB(weakKing) | squareBB(piece);
+		bool inCheck = !(pieceAttacks(type, piece, occupied) & squareBB(weakKing)).empty();
+
+		// The weaker king can't be in check with the stronger side to move
+		if (!weakToMove && inCheck)
+		{
+			states[index] = INVALID;
+		}
+	}
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (int index = 0; index < kPositions; index++)
+		{
+			if (states[index] != UNKNOWN)
+			{
+				continue;
+			}
+
+			int piece = index & 63;
+			int weakKing = (index >> 6) & 63;
+			int strongKing = (index >> 12) & 63;
+			int weakToMove = index >> 18;
+			chess::Bitboard occupied = squareBB(strongKing) | squareBB(weakKing) | squareBB(piece);
+			bool won = false;
+
+			if (weakToMove)
+			{
+				// Squares the weaker king can't step onto. Sliders see through the
+				// king's own square, since it won't be standing there any more.
+				chess::Bitboard attacked = chess::attacks::king(chess::Square(strongKing)) |
+					pieceAttacks(type, piece, squareBB(strongKing) | squareBB(piece));
+				chess::Bitboard targets = chess::attacks::king(chess::Square(weakKing)) & ~attacked;
+
+				if (targets.empty())
+				{
+					// Checkmate is won, stalemate is drawn
+					won = !(pieceAttacks(type, piece, occupied) & squareBB(weakKing)).empty();
+				}
+
+				else
+				{
+					// Won only if every escape is lost. Taking the piece draws.
+					won = true;
+					while (won && !targets.empty())
+					{
+						int target = targets.pop();
+						won = target != piece && states[bitbaseIndex(0, strongKing, target, piece)] == WON;
+					}
+				}
+			}
+
+			else
+			{
+				chess::Bitboard kingTargets = chess::attacks::king(chess::Square(strongKing)) &
+					~squareBB(piece) & ~squareBB(weakKing) & ~chess::attacks::king(chess::Square(weakKing));
+				while (!won && !kingTargets.empty())
+				{
+					int target = kingTargets.pop();
+					won = states[bitbaseIndex(1, target, weakKing, piece)] == WON;
+				}
+
+				if (isPawn)
+				{
+					int push = piece + 8;
+					bool pushFree = push != strongKing && push != weakKing;
+					if (!won && pushFree && push >= 56)
+					{
+						// Promote to a queen, or a rook where the queen would stalemate
+						won = isWin(KQK, bitbaseIndex(1, strongKing, weakKing, push)) ||
+							isWin(KRK, bitbaseIndex(1, strongKing, weakKing, push));
+					}
+
+					else if (!won && pushFree)
+					{
+						won = states[bitbaseIndex(1, strongKing, weakKing, push)] == WON;
+
+						int doublePush = piece + 16;
+						if (!won && piece < 16 && doublePush != strongKing && doublePush != weakKing)
+						{
+							won = states[bitbaseIndex(1, strongKing, weakKing, doublePush)] == WON;
+						}
+					}
+				}
+
+				else
+				{
+					chess::Bitboard pieceTargets = pieceAttacks(type, piece, occupied) & ~squareBB(strongKing) & ~squareBB(weakKing);
+					while (!won && !pieceTargets.empty())
+					{
+						int target = pieceTargets.pop();
+						won = states[bitbaseIndex(1, strongKing, weakKing, target)] == WON;
+					}
+				}
+			}
+
+			if (won)
+			{
+				states[index] = WON;
+				changed = true;
+			}
+		}
+	}
+
+	// Pack the won positions into bits
+	m_Tables[table].assign(kWords, 0);
+	for (int index = 0; index < kPositions; index++)
+	{
+		if (states[index] == WON)
+		{
+			m_Tables[table][index / 64] |= 1ULL << (index % 64);
+		}
+	}
+}
+
+bool EndgameBitbases::save(const std::string& path) const
+{
+	if (!m_Ready)
+	{
+		return false;
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	std::uint32_t header[2] = { kMagic, kVersion };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	for (int table = 0; table < TABLE_COUNT; table++)
+	{
+		file.write(reinterpret_cast<const char*>(m_Tables[table].data()), kWords * sizeof(std::uint64_t));
+	}
+
+	return file.good();
+}
+
+bool EndgameBitbases::load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::uint32_t header[2] = {};
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!file || header[0] != kMagic || header[1] != kVersion)
+	{
+		return false;
+	}
+
+	for (int table = 0; table < TABLE_COUNT; table++)
+	{
+		m_Tables[table].resize(kWords);
+		file.read(reinterpret_cast<char*>(m_Tables[table].data()), kWords * sizeof(std::uint64_t));
+	}
+
+	m_Ready = file.good();
+	return m_Ready;
+}
+
+bool EndgameBitbases::isReady() const
+{
+	return m_Ready;
+}
+
+bool EndgameBitbases::isWin(int table, int index) const
+{
+	return (m_Tables[table][index / 64] >> (index % 64)) & 1;
+}
+
+bool EndgameBitbases::probe(const chess::Board& board, BitbaseResult& result) const
+{
+	if (!m_Ready || board.occ().count() != 3)
+	{
+		return false;
+	}
+
+	chess::Bitboard others = board.occ() & ~board.pieces(chess::PieceType::KING);
+	chess::Square pieceSquare(others.lsb());
+	chess::Piece piece = board.at(pieceSquare);
+
+	int table = TABLE_COUNT;
+	if (piece.type() == chess::PieceType::PAWN)
+	{
+		table = KPK;
+	}
+
+	else if (piece.type() == chess::PieceType::ROOK)
+	{
+		table = KRK;
+	}
+
+	else if (piece.type() == chess::PieceType::QUEEN)
+	{
+		table = KQK;
+	}
+
+	if (table == TABLE_COUNT)
+	{
+		return false;
+	}
+
+	// Tables have the stronger side as white, so flip black's positions
+	chess::Color strong = piece.color();
+	int strongKing = board.kingSq(strong).index();
+	int weakKing = board.kingSq(~strong).index();
+	int square = pieceSquare.index();
+	if (strong == chess::Color::BLACK)
+	{
+		strongKing ^= 56;
+		weakKing ^= 56;
+		square ^= 56;
+	}
+
+	int weakToMove = board.sideToMove() == strong ? 0 : 1;
+	if (!isWin(table, bitbaseIndex(weakToMove, strongKing, weakKing, square)))
+	{
+		result = BitbaseResult::DRAW;
+	}
+
+	else
+	{
+		result = weakToMove ? BitbaseResult::LOSS : BitbaseResult::WIN;
+	}
+
+	return true;
+}
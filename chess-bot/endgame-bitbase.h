@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "chess.hpp"
+
+namespace ChessSimulator {
+	// Exact result of a position for the side to move
+	enum class BitbaseResult
+	{
+		WIN,
+		DRAW,
+		LOSS
+	};
+
+	/*
+	* Win/draw bitbases for king and piece against king endings (KPK, KRK and KQK).
+	*
+	* - Tables are built by retrograde analysis: checkmates are marked won for the stronger side,
+	*	then positions are repeatedly marked won when the stronger side has a move into a won
+	*	position, or the weaker side only has moves into won positions, until nothing changes.
+	*	Pawn promotions look the result up in the KQK and KRK tables.
+	* - Positions are stored from the stronger side's view as white, one bit each (won or not),
+	*	indexed by side to move, both king squares and the piece square. Each table is 64KB.
+	* - The weaker side can't win these endings, so a clear bit is a draw.
+	* - Tables can be saved to and loaded from a file to skip generating them at startup.
+	*/
+	class EndgameBitbases
+	{
+	public:
+		// Build every table, takes a moment
+		void generate();
+
+		bool save(const std::string& path) const;
+		bool load(const std::string& path);
+		bool isReady() const;
+
+		// Look up a position. Returns false if no table covers it.
+		bool probe(const chess::Board& board, BitbaseResult& result) const;
+
+	private:
+		void generateTable(int table, chess::PieceType type);
+		bool isWin(int table, int index) const;
+
+		std::vector<std::uint64_t> m_Tables[3];
+		bool m_Ready = false;
+	};
+}
@@ -0,0 +1,174 @@
+#include "eval-cache.h"
+#include <cstring>
+
+using namespace ChessSimulator;
+
+namespace {
+	// Set on the data of every stored entry, so empty entries never match
+	constexpr std::uint64_t kValid = 1ull << 63;
+
+	std::uint64_t mix(std::uint64_t x)
+	{
+		x ^= x >> 30;
+		x *= 0xBF58476D1CE4E5B9ull;
+		x ^= x >> 27;
+		x *= 0x94D049BB133111EBull;
+		x ^= x >> 31;
+		return x;
+	}
+
+	// Counter stripe of the calling thread, handed out round robin
+	std::atomic<int> nextStripe = 0;
+
+	int threadStripe(int stripes)
+	{
+		thread_local int stripe = nextStripe.fetch_add(1, std::memory_order_relaxed);
+		return stripe % stripes;
+	}
+}
+
+void EvalCache::resize(std::size_t bytes)
+{
+	std::size_t buckets = 1;
+	while (buckets * 2 * sizeof(Bucket) <= bytes)
+	{
+		buckets *= 2;
+	}
+
+	m_Buckets.reset();
+	m_Mask = 0;
+	if (bytes < sizeof(Bucket))
+	{
+		return;
+	}
+
+	m_Buckets = std::make_unique<Bucket[]>(buckets);
+	m_Mask = buckets - 1;
+	clear();
+}
+
+void EvalCache::clear()
+{
+	for (std::uint64_t i = 0; m_Buckets && i <= m_Mask; i++)
+	{
+		for (auto& entry : m_Buckets[i].entries)
+		{
+			entry.check.store(0, std::memory_order_relaxed);
+			entry.data.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	for (auto& counters : m_Counters)
+	{
+		counters.probes.store(0, std::memory_order_relaxed);
+		counters.hits.store(0, std::memory_order_relaxed);
+	}
+}
+
+bool EvalCache::isReady() const
+{
+	return m_Buckets != nullptr;
+}
+
+bool EvalCache::probe(std::uint64_t key, float& value)
+{
+	if (!m_Buckets)
+	{
+		return false;
+	}
+
+	Counters& counters = m_Counters[threadStripe(COUNTER_STRIPES)];
+	counters.probes.fetch_add(1, std::memory_order_relaxed);
+	Bucket& bucket = m_Buckets[key & m_Mask];
+	for (auto& entry : bucket.entries)
+	{
+		std::uint64_t data = entry.data.load(std::memory_order_relaxed);
+		std::uint64_t check = entry.check.load(std::memory_order_relaxed);
+		if ((data & kValid) && (check ^ data) == key)
+		{
+			std::uint32_t bits = static_cast<std::uint32_t>(data);
+			std::memcpy(&value, &bits, sizeof(value));
+			counters.hits.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void EvalCache::store(std::uint64_t key, float value)
+{
+	if (!m_Buckets)
+	{
+		return;
+	}
+
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	std::uint64_t data = kValid | bits;
+
+	Bucket& bucket = m_Buckets[key & m_Mask];
+	Entry* target = &bucket.entries[key >> 62];
+	for (auto& entry : bucket.entries)
+	{
+		std::uint64_t entryData = entry.data.load(std::memory_order_relaxed);
+		std::uint64_t entryCheck = entry.check.load(std::memory_order_relaxed);
+		if (!(entryData & kValid) || (entryCheck ^ entryData) == key)
+		{
+			target = &entry;
+			break;
+		}
+	}
+
+	target->check.store(key ^ data, std::memory_order_relaxed);
+	target->data.store(data, std::memory_order_relaxed);
+}
+
+std::size_t EvalCache::getBytes() const
+{
+	return m_Buckets ? (m_Mask + 1) * sizeof(Bucket) : 0;
+}
+
+std::uint64_t EvalCache::getProbes() const
+{
+	std::uint64_t probes = 0;
+	for (auto const& counters : m_Counters)
+	{
+		probes += counters.probes.load(std::memory_order_relaxed);
+	}
+	return probes;
+}
+
+std::uint64_t EvalCache::getHits() const
+{
+	std::uint64_t hits = 0;
+	for (auto const& counters : m_Counters)
+	{
+		hits += counters.hits.load(std::memory_order_relaxed);
+	}
+	return hits;
+}
+
+double EvalCache::getHitRate() const
+{
+	std::uint64_t probes = getProbes();
+	return probes ? static_cast<double>(getHits()) / probes : 0.0;
+}
+
+std::uint64_t EvalCache::pawnKey(std::uint64_t whitePawns, std::uint64_t blackPawns)
+{
+	return mix(whitePawns) ^ mix(blackPawns ^ 0x9E3779B97F4A7C15ull);
+}
+
+std::uint64_t EvalCache::saltOf(const void* data, std::size_t bytes)
+{
+	// FNV-1a, mixed at the end so similar parameters give unrelated salts
+	const unsigned char* values = static_cast<const unsigned char*>(data);
+	std::uint64_t hash = 0xCBF29CE484222325ull;
+	for (std::size_t i = 0; i < bytes; i++)
+	{
+		hash = (hash ^ values[i]) * 0x100000001B3ull;
+	}
+
+	return mix(hash);
+}
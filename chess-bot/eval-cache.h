@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ChessSimulator {
+	/*
+	* Fixed-size, lock-free cache of evaluations keyed by 64 bit hashes.
+	*
+	* - The table is split into 64 byte buckets of four entries, so a probe touches one cache line.
+	* - Entries are two words written without locks: the key xor'd with the data, and the data.
+	*	A reader only accepts an entry whose words xor back to its key, so an entry torn by two
+	*	threads writing at once reads as a miss rather than a wrong value.
+	* - A store replaces the entry holding the same key, an empty one, or else the one picked
+	*	by the key's high bits.
+	* - Probes and hits are counted for hit-rate statistics, on counters striped by thread so
+	*	threads sharing the cache don't contend on them. Reading the statistics sums the stripes.
+	* - Any number of threads and searches can share a cache, but it holds one evaluation
+	*	function's values: callers salt keys to keep different evaluations apart, with a salt
+	*	made from the evaluation's parameters (see saltOf) when they can differ.
+	*/
+	class EvalCache
+	{
+	public:
+		// Drop every entry and take up to bytes of memory, rounded down to a power of two buckets
+		void resize(std::size_t bytes);
+		void clear();
+		bool isReady() const;
+
+		bool probe(std::uint64_t key, float& value);
+		void store(std::uint64_t key, float value);
+
+		std::size_t getBytes() const;
+		std::uint64_t getProbes() const;
+		std::uint64_t getHits() const;
+		double getHitRate() const;
+
+		// Key of a pawn skeleton, for caching pawn structure terms
+		static std::uint64_t pawnKey(std::uint64_t whitePawns, std::uint64_t blackPawns);
+		// Salt from the bytes of an evaluation's parameters
+		static std::uint64_t saltOf(const void* data, std::size_t bytes);
+
+	private:
+		struct Entry
+		{
+			std::atomic<std::uint64_t> check = 0;
+			std::atomic<std::uint64_t> data = 0;
+		};
+
+		struct alignas(64) Bucket
+		{
+			Entry entries[4];
+		};
+
+		struct alignas(64) Counters
+		{
+			std::atomic<std::uint64_t> probes = 0;
+			std::atomic<std::uint64_t> hits = 0;
+		};
+		static constexpr int COUNTER_STRIPES = 64;
+
+		std::unique_ptr<Bucket[]> m_Buckets;
+		std::uint64_t m_Mask = 0;
+
+		Counters m_Counters[COUNTER_STRIPES];
+	};
+}
@@ -0,0 +1,181 @@
+#include "eval-weights.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+
+using namespace ChessSimulator;
+
+namespace {
+	constexpr std::uint32_t kMagic = 0x574C5645; // "EVLW"
+	constexpr std::uint32_t kVersion = 2;
+}
+
+bool EvalWeights::load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::uint32_t header[2] = {};
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!file || header[0] != kMagic || header[1] != kVersion)
+	{
+		return false;
+	}
+
+	EvalWeights weights;
+	file.read(reinterpret_cast<char*>(&weights.scale), sizeof(weights.scale));
+	file.read(reinterpret_cast<char*>(weights.material), sizeof(weights.material));
+	file.read(reinterpret_cast<char*>(weights.pieceSquare), sizeof(weights.pieceSquare));
+	file.read(reinterpret_cast<char*>(&weights.doubledPawn), sizeof(weights.doubledPawn));
+	file.read(reinterpret_cast<char*>(&weights.isolatedPawn), sizeof(weights.isolatedPawn));
+	file.read(reinterpret_cast<char*>(weights.passedPawn), sizeof(weights.passedPawn));
+	if (!file)
+	{
+		return false;
+	}
+
+	*this = weights;
+	return true;
+}
+
+bool EvalWeights::save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	std::uint32_t header[2] = { kMagic, kVersion };
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(&scale), sizeof(scale));
+	file.write(reinterpret_cast<const char*>(material), sizeof(material));
+	file.write(reinterpret_cast<const char*>(pieceSquare), sizeof(pieceSquare));
+	file.write(reinterpret_cast<const char*>(&doubledPawn), sizeof(doubledPawn));
+	file.write(reinterpret_cast<const char*>(&isolatedPawn), sizeof(isolatedPawn));
+	file.write(reinterpret_cast<const char*>(passedPawn), sizeof(passedPawn));
+	return file.good();
+}
+
+bool EvalWeights::saveHeader(const std::string& path, const std::string& name) const
+{
+	std::ofstream file(path);
+	file << std::fixed << std::setprecision(2);
+	file << "#pragma once\n#include \"eval-weights.h\"\n\n";
+	file << "// Generated by chesstune\n";
+	file << "namespace ChessSimulator {\n";
+	file << "\tinline const EvalWeights " << name << " = {\n";
+	file << "\t\t" << scale << "f,\n";
+
+	file << "\t\t{";
+	for (int i = 0; i < 6; i++)
+	{
+		file << (i ? ", " : " ") << material[i] << "f";
+	}
+	file << " },\n";
+
+	file << "\t\t{\n";
+	for (int type = 0; type < 6; type++)
+	{
+		file << "\t\t\t{";
+		for (int square = 0; square < 64; square++)
+		{
+			file << (square % 8 == 0 ? "\n\t\t\t\t" : " ") << pieceSquare[type][square] << "f,";
+		}
+		file << "\n\t\t\t},\n";
+	}
+	file << "\t\t},\n";
+
+	file << "\t\t" << doubledPawn << "f,\n";
+	file << "\t\t" << isolatedPawn << "f,\n";
+	file << "\t\t{";
+	for (int i = 0; i < 8; i++)
+	{
+		file << (i ? ", " : " ") << passedPawn[i] << "f";
+	}
+	file << " }\n\t};\n}\n";
+
+	return file.good();
+}
+
+float EvalWeights::evaluate(const chess::Board& board) const
+{
+	std::uint64_t whitePawns = board.pieces(chess::PieceType::PAWN, chess::Color::WHITE).getBits();
+	std::uint64_t blackPawns = board.pieces(chess::PieceType::PAWN, chess::Color::BLACK).getBits();
+	return evaluatePieces(board) + evaluatePawns(whitePawns, blackPawns);
+}
+
+float EvalWeights::evaluatePieces(const chess::Board& board) const
+{
+	float value = 0;
+	for (int type = 0; type < 6; type++)
+	{
+		chess::PieceType pieceType(static_cast<chess::PieceType::underlying>(type));
+
+		chess::Bitboard white = board.pieces(pieceType, chess::Color::WHITE);
+		while (white)
+		{
+			value += material[type] + pieceSquare[type][white.pop()];
+		}
+
+		chess::Bitboard black = board.pieces(pieceType, chess::Color::BLACK);
+		while (black)
+		{
+			value -= material[type] + pieceSquare[type][black.pop() ^ 56];
+		}
+	}
+
+	return value;
+}
+
+float EvalWeights::evaluatePawns(std::uint64_t whitePawns, std::uint64_t blackPawns) const
+{
+	float value = 0;
+	for (int side = 0; side < 2; side++)
+	{
+		// Black's pawns are flipped to move up the board like white's
+		PawnCounts counts = side == 0 ? countPawns(whitePawns, blackPawns)
+			: countPawns(std::byteswap(blackPawns), std::byteswap(whitePawns));
+
+		float sideValue = counts.doubled * doubledPawn + counts.isolated * isolatedPawn;
+		for (int rank = 0; rank < 8; rank++)
+		{
+			sideValue += counts.passed[rank] * passedPawn[rank];
+		}
+
+		value += side == 0 ? sideValue : -sideValue;
+	}
+
+	return value;
+}
+
+EvalWeights::PawnCounts EvalWeights::countPawns(std::uint64_t ownPawns, std::uint64_t enemyPawns)
+{
+	constexpr std::uint64_t fileA = 0x0101010101010101ull;
+
+	PawnCounts counts;
+	for (int file = 0; file < 8; file++)
+	{
+		std::uint64_t fileMask = fileA << file;
+		std::uint64_t adjacent = (file > 0 ? fileMask >> 1 : 0) | (file < 7 ? fileMask << 1 : 0);
+		int pawns = std::popcount(ownPawns & fileMask);
+
+		counts.doubled += std::max(0, pawns - 1);
+		if (pawns > 0 && !(ownPawns & adjacent))
+		{
+			counts.isolated += pawns;
+		}
+
+		std::uint64_t filePawns = ownPawns & fileMask;
+		while (filePawns)
+		{
+			int square = std::countr_zero(filePawns);
+			filePawns &= filePawns - 1;
+
+			// Passed when no enemy pawn stands ahead on its own or a neighbouring file
+			int rank = square / 8;
+			std::uint64_t ahead = rank < 7 ? ~0ull << ((rank + 1) * 8) : 0;
+			if (!(enemyPawns & (fileMask | adjacent) & ahead))
+			{
+				counts.passed[rank]++;
+			}
+		}
+	}
+
+	return counts;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "chess.hpp"
+
+namespace ChessSimulator {
+	/*
+	* Material and piece-square weights of the static evaluation.
+	*
+	* - Weights are centipawns for white pieces. Black pieces count negatively and look up
+	*	their square mirrored vertically, so tables are always from the owner's side.
+	* - Kings cancel out and carry no material weight, only a piece-square one.
+	* - Pawn structure terms (doubled, isolated and passed pawns by rank) only depend on
+	*	the pawns, so evaluatePawns() can be cached by pawn skeleton.
+	* - scale is the logistic scale the weights were tuned against: a position evaluated at
+	*	e centipawns is expected to score 1 / (1 + exp(-e / scale)) for white.
+	* - Weights files (chesstune output) are little endian: u32 magic 'EVLW', u32 version,
+	*	then scale, material[6], pieceSquare[6][64], doubledPawn, isolatedPawn and
+	*	passedPawn[8] as floats.
+	* - The defaults are the evaluator's original hand-picked piece values with empty tables
+	*	and no pawn structure terms, so only loaded weights change the evaluation.
+	*/
+	struct EvalWeights
+	{
+		float scale = 400.0f;
+		float material[6] = { 100, 350, 350, 500, 1000, 0 };
+		float pieceSquare[6][64] = {};
+		float doubledPawn = 0;
+		float isolatedPawn = 0;
+		// By rank from the pawn's own side
+		float passedPawn[8] = {};
+
+		// Pawn structure counts of one side, with its pawns moving up the board
+		struct PawnCounts
+		{
+			int doubled = 0;
+			int isolated = 0;
+			int passed[8] = {};
+		};
+		static PawnCounts countPawns(std::uint64_t ownPawns, std::uint64_t enemyPawns);
+
+		bool load(const std::string& path);
+		bool save(const std::string& path) const;
+		// Write the weights as a C++ header defining an EvalWeights called name
+		bool saveHeader(const std::string& path, const std::string& name) const;
+
+		// Centipawns from white's point of view
+		float evaluate(const chess::Board& board) const;
+		// Material and piece-square part of evaluate()
+		float evaluatePieces(const chess::Board& board) const;
+		// Pawn structure part of evaluate()
+		float evaluatePawns(std::uint64_t whitePawns, std::uint64_t blackPawns) const;
+	};
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "chess.hpp"
+
+namespace ChessSimulator {
+	/*
+	* Interface for valuing search leaves in batches.
+	*
+	* The search collects leaves and hands them over together, so implementations can
+	* set up once and run their kernels over many positions at a time. Values are in
+	* [-1, 1] from the point of view of the side to move in each position.
+	*/
+	class MCTS_LeafEvaluator
+	{
+	public:
+		virtual ~MCTS_LeafEvaluator() = default;
+
+		virtual void evaluateBatch(const chess::Board* boards, int count, float* values) = 0;
+	};
+}
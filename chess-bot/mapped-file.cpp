@@ -0,0 +1,90 @@
+#include "mapped-file.h"
+#include <fstream>
+#include <iterator>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define MAPPED_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace ChessSimulator;
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef MAPPED_FILE_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			m_Data = static_cast<const unsigned char*>(data);
+			m_Size = info.st_size;
+			m_Mapped = true;
+		}
+	}
+
+	::close(fd);
+#endif
+
+	if (!m_Mapped)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			return false;
+		}
+
+		m_Buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		m_Data = m_Buffer.data();
+		m_Size = m_Buffer.size();
+	}
+
+	return m_Size != 0;
+}
+
+void MappedFile::close()
+{
+#ifdef MAPPED_FILE_MMAP
+	if (m_Mapped)
+	{
+		munmap(const_cast<unsigned char*>(m_Data), m_Size);
+	}
+#endif
+
+	m_Buffer.clear();
+	m_Data = nullptr;
+	m_Size = 0;
+	m_Mapped = false;
+}
+
+bool MappedFile::isOpen() const
+{
+	return m_Size != 0;
+}
+
+const unsigned char* MappedFile::data() const
+{
+	return m_Data;
+}
+
+size_t MappedFile::size() const
+{
+	return m_Size;
+}
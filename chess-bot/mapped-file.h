@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ChessSimulator {
+	/*
+	* Read-only view of a whole file. The file is memory-mapped where the platform
+	* allows it and read into memory otherwise, so callers only ever see a pointer
+	* and a size.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool open(const std::string& path);
+		void close();
+		bool isOpen() const;
+
+		const unsigned char* data() const;
+		size_t size() const;
+
+	private:
+		const unsigned char* m_Data = nullptr;
+		size_t m_Size = 0;
+
+		// Holds the file when it couldn't be mapped
+		std::vector<unsigned char> m_Buffer;
+		bool m_Mapped = false;
+	};
+}
@@ -0,0 +1,189 @@
+#include "mcts-ensemble.h"
+#include <memory>
+#include <new>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define MCTS_ENSEMBLE_FORK 1
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace ChessSimulator;
+
+namespace {
+	// Upper bound on legal moves in any chess position is 218
+	constexpr int kMaxRootMoves = 256;
+
+	// One worker's slot in the shared segment. A count of -1 means
+	// the worker never reported (crashed or failed to start).
+	struct EnsembleSlot
+	{
+		std::int32_t count = -1;
+		MCTS_RootStat stats[kMaxRootMoves];
+	};
+
+	// Run a single search and copy its root statistics into a slot
+	void runSearch(const chess::Board& root, int depth, std::uint32_t seed, const MCTS_Settings& settings, EnsembleSlot& slot)
+	{
+		// The stat tree is too large to comfortably live on the stack
+		auto evaluator = std::make_unique<MCTS_Evaluator>(root, depth, seed, settings);
+		evaluator->genMove();
+
+		std::vector<MCTS_RootStat> stats = evaluator->getRootStats();
+		int count = 0;
+		for (auto const& stat : stats)
+		{
+			if (count == kMaxRootMoves)
+			{
+				break;
+			}
+			slot.stats[count] = stat;
+			count++;
+		}
+		slot.count = count;
+	}
+}
+
+MCTS_Ensemble::MCTS_Ensemble(chess::Board root, int depth, int workers, std::uint32_t seed)
+	: MCTS_Ensemble(root, depth, workers, seed, MCTS_Settings())
+{
+}
+
+MCTS_Ensemble::MCTS_Ensemble(chess::Board root, int depth, int workers, std::uint32_t seed, const MCTS_Settings& settings)
+{
+	m_RootBoard = root;
+	m_Cycles = depth;
+	m_Workers = workers < 1 ? 1 : workers;
+	m_Seed = seed;
+	m_Settings = WithProcessTables(settings);
+}
+
+chess::Move MCTS_Ensemble::genMove()
+{
+	m_Merged.clear();
+
+	if (!runProcesses())
+	{
+		runInProcess();
+	}
+
+	// Pick the move with the best summed reward, matching
+	// how a single MCTS_Evaluator picks its move
+	if (m_Merged.empty())
+	{
+		return chess::Move(chess::Move::NO_MOVE);
+	}
+
+	const MCTS_RootStat* best = &m_Merged[0];
+	for (auto const& stat : m_Merged)
+	{
+		if (stat.simReward > best->simReward)
+		{
+			best = &stat;
+		}
+	}
+
+	return chess::Move(best->move);
+}
+
+const std::vector<MCTS_RootStat>& MCTS_Ensemble::getMergedStats() const
+{
+	return m_Merged;
+}
+
+void MCTS_Ensemble::mergeStats(std::vector<MCTS_RootStat>& merged, const MCTS_RootStat* stats, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		bool found = false;
+		for (auto& existing : merged)
+		{
+			if (existing.move == stats[i].move)
+			{
+				existing.visits += stats[i].visits;
+				existing.simReward += stats[i].simReward;
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+		{
+			merged.push_back(stats[i]);
+		}
+	}
+}
+
+// Fork one process per worker and merge their results from shared memory.
+// Returns false if the processes couldn't be set up.
+bool MCTS_Ensemble::runProcesses()
+{
+#ifdef MCTS_ENSEMBLE_FORK
+	size_t segmentSize = sizeof(EnsembleSlot) * m_Workers;
+	void* segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (segment == MAP_FAILED)
+	{
+		return false;
+	}
+
+	EnsembleSlot* slots = static_cast<EnsembleSlot*>(segment);
+	for (int i = 0; i < m_Workers; i++)
+	{
+		new (&slots[i]) EnsembleSlot();
+	}
+
+	std::vector<pid_t> children;
+	for (int i = 0; i < m_Workers; i++)
+	{
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			// Worker process: search, publish and leave without
+			// running the parent's atexit handlers
+			runSearch(m_RootBoard, m_Cycles, m_Seed + i, m_Settings, slots[i]);
+			_exit(0);
+		}
+
+		if (pid > 0)
+		{
+			children.push_back(pid);
+		}
+
+		else
+		{
+			// Couldn't fork, run this worker here instead
+			runSearch(m_RootBoard, m_Cycles, m_Seed + i, m_Settings, slots[i]);
+		}
+	}
+
+	for (auto const pid : children)
+	{
+		int status = 0;
+		waitpid(pid, &status, 0);
+	}
+
+	for (int i = 0; i < m_Workers; i++)
+	{
+		if (slots[i].count > 0)
+		{
+			mergeStats(m_Merged, slots[i].stats, slots[i].count);
+		}
+	}
+
+	munmap(segment, segmentSize);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void MCTS_Ensemble::runInProcess()
+{
+	auto slot = std::make_unique<EnsembleSlot>();
+	for (int i = 0; i < m_Workers; i++)
+	{
+		runSearch(m_RootBoard, m_Cycles, m_Seed + i, m_Settings, *slot);
+		mergeStats(m_Merged, slot->stats, slot->count);
+	}
+}
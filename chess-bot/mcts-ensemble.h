@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "chess-simulator.h"
+
+namespace ChessSimulator {
+	/*
+	* Root-parallel ensemble of independent MCTS searches.
+	*
+	* - Each worker runs its own MCTS_Evaluator from the same root with a distinct seed,
+	*	built from the settings the ensemble was given (see WithProcessTables). Workers
+	*	get their own copy of everything the settings point at, and their callbacks and
+	*	trace run in the worker, so leave those unset.
+	* - Workers run as separate processes (fork) so they share no allocator or caches,
+	*	and write their root statistics into a shared memory segment mapped before forking.
+	* - The coordinator sums visits and rewards per root move and picks the final move
+	*	from the merged statistics, the same way a single search picks from its own.
+	* - MCTS_RootStat is the merge format, so results produced elsewhere (other hosts,
+	*	files) can be folded in with mergeStats() as well.
+	* - Where fork() isn't available the workers are run one after another in-process.
+	*/
+	class MCTS_Ensemble
+	{
+	public:
+		MCTS_Ensemble(chess::Board root, int depth, int workers, std::uint32_t seed);
+		MCTS_Ensemble(chess::Board root, int depth, int workers, std::uint32_t seed, const MCTS_Settings& settings);
+
+		chess::Move genMove();
+
+		// Merged root statistics from the last genMove() call
+		const std::vector<MCTS_RootStat>& getMergedStats() const;
+
+		// Add a worker's root statistics into a merged set, summing per move
+		static void mergeStats(std::vector<MCTS_RootStat>& merged, const MCTS_RootStat* stats, int count);
+
+	private:
+		bool runProcesses();
+		void runInProcess();
+
+		chess::Board m_RootBoard;
+		int m_Cycles = 0;
+		int m_Workers = 1;
+		std::uint32_t m_Seed = 0;
+		MCTS_Settings m_Settings;
+
+		std::vector<MCTS_RootStat> m_Merged;
+	};
+}
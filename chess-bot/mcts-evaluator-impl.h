@@ -0,0 +1,1631 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <stop_token>
+#include "chess-simulator.h"
+#include "move-heuristics.h"
+
+// Member definitions of MCTS_BasicEvaluator. Include this to build an evaluator from other policies.
+namespace ChessSimulator {
+	// Halfmove clock past which a bitbase win might not be mated before the
+	// fifty-move rule. The longest mates the bitbases cover (KRK) take 16 moves.
+	constexpr int MCTS_BITBASE_MAX_CLOCK = 100 - 2 * 16;
+
+	template <typename Policies>
+	MCTS_BasicEvaluator<Policies>::MCTS_BasicEvaluator(chess::Board root, int depth)
+		: MCTS_BasicEvaluator(root, depth, std::random_device()())
+	{
+	}
+
+	template <typename Policies>
+	MCTS_BasicEvaluator<Policies>::MCTS_BasicEvaluator(chess::Board root, int depth, std::uint32_t seed)
+		: MCTS_BasicEvaluator(root, depth, seed, MCTS_Settings())
+	{
+	}
+
+	template <typename Policies>
+	MCTS_BasicEvaluator<Policies>::MCTS_BasicEvaluator(chess::Board root, int depth, std::uint32_t seed, const MCTS_Settings& settings)
+	{
+		m_RootBoard = root;
+		m_Cycles = depth;
+		m_Rng.seed(seed);
+		m_Settings = settings;
+		m_StatTree.resize(std::max(2, m_Settings.treeSize));
+
+		// Each worker gets its own generator, seeded off the main one
+		int threads = std::max(1, m_Settings.threads);
+		for (int i = 0; i < threads; i++)
+		{
+			m_WorkerRngs.emplace_back(m_Rng());
+		}
+		m_WorkerBoards.resize(threads);
+
+		if (threads > 1)
+		{
+			m_Pool = std::make_unique<MCTS_WorkerPool>(threads);
+		}
+
+		if (LeafEvalPolicy::mode(m_Settings) == MCTS_LeafEval::NNUE && m_Settings.network && m_Settings.network->isLoaded())
+		{
+			m_Nnue = std::make_unique<NNUE_Evaluator>(*m_Settings.network);
+		}
+
+		if (m_Settings.evalWeights)
+		{
+			m_EvalWeights = *m_Settings.evalWeights;
+		}
+
+		// Cache keys are salted with what the values depend on, so searches
+		// with other weights or networks can share the caches
+		m_StaticSalt = 0x5354415449430000ull ^ EvalCache::saltOf(&m_EvalWeights, sizeof(m_EvalWeights));
+		if (m_Nnue)
+		{
+			m_NetworkSalt = 0x4E4E554500000000ull ^ m_Settings.network->getFingerprint();
+		}
+	}
+
+	template <typename Policies>
+	MCTS_BasicEvaluator<Policies>::~MCTS_BasicEvaluator()
+	{
+
+	}
+
+	template <typename Policies>
+	chess::Move MCTS_BasicEvaluator<Policies>::genMove()
+	{
+		return genMove(std::stop_token());
+	}
+
+	template <typename Policies>
+	chess::Move MCTS_BasicEvaluator<Policies>::genMove(std::stop_token stop)
+	{
+		MCTS_Node& rootNode = m_StatTree[0];
+		m_Stop = stop;
+		m_SearchStart = std::chrono::steady_clock::now();
+		m_SearchPlayouts = m_Playouts;
+		m_SearchCycles = 0;
+
+		// The tree may have been moved or replaced since the last search
+		m_SimBoard = m_RootBoard;
+		m_SimIndex = 0;
+
+		bool batching = LeafEvalPolicy::mode(m_Settings) == MCTS_LeafEval::BATCH && m_Settings.batchEvaluator;
+
+		// A tree loaded from a snapshot already has its root expanded
+		if (!m_WarmStart)
+		{
+			// Init root tree node
+			rootNode.parentIndex = -1;
+			rootNode.visits = 0;
+			rootNode.simReward = 0;
+			rootNode.depth = 0;
+			rootNode.proof = MCTS_Proof::NONE;
+			m_FreeIndex = 1;
+			m_TreeFull = false;
+			rollout(0);
+
+			if (batching)
+			{
+				queueChildren(0);
+				flushBatch();
+			}
+
+			else
+			{
+				simulateChildren(0);
+			}
+		}
+		m_WarmStart = false;
+
+		// Do MCTS cycles based on the tree resolution
+		// specified by the class. Once the root is
+		// solved there's nothing left to search. Once
+		// the tree is full cycles revisit leaves instead
+		// of expanding them (see revisitLeaf).
+		// A stop request is checked before every cycle.
+		bool unbounded = m_Cycles < 0;
+		int currentCycle = m_Cycles;
+		int nextReport = m_Cycles - m_Settings.analysisInterval;
+		auto nextProgress = m_SearchStart + std::chrono::milliseconds(m_Settings.progressInterval);
+		while ((unbounded || currentCycle >= 0) && rootNode.proof == MCTS_Proof::NONE && !m_Stop.stop_requested())
+		{
+			int cycles = 1;
+			if (batching)
+			{
+				cycles = batchCycle(unbounded ? std::numeric_limits<int>::max() : currentCycle + 1);
+			}
+
+			else
+			{
+				cycle();
+			}
+			currentCycle -= cycles;
+			m_SearchCycles += cycles;
+
+			if (m_Settings.analysis && m_Settings.analysisInterval > 0 && currentCycle <= nextReport)
+			{
+				reportAnalysis();
+				nextReport = currentCycle - m_Settings.analysisInterval;
+			}
+
+			if (m_Settings.progress && m_Settings.progressInterval > 0 && std::chrono::steady_clock::now() >= nextProgress)
+			{
+				reportProgress();
+				nextProgress = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_Settings.progressInterval);
+			}
+		}
+
+		if (m_Settings.analysis)
+		{
+			reportAnalysis();
+		}
+
+		if (m_Settings.progress)
+		{
+			reportProgress();
+		}
+		m_Stop = std::stop_token();
+
+		if (m_Settings.trace)
+		{
+			m_Settings.trace->flush();
+		}
+
+		// Return the move used to reach the best node
+		return m_StatTree[bestRootChild()].move;
+	}
+
+	// Pick the root child to play. Proven wins are played straight
+	// away and proven losses are only played if nothing else is left.
+	template <typename Policies>
+	int MCTS_BasicEvaluator<Policies>::bestRootChild()
+	{
+		const MCTS_Node& rootNode = m_StatTree[0];
+		int bestIndex = -1;
+		for (auto const index : rootNode.childIndices)
+		{
+			const MCTS_Node& child = m_StatTree[index];
+			if (child.proof == MCTS_Proof::ROOT_WIN)
+			{
+				return index;
+			}
+
+			// A solved draw is the best there is when the root is a proven draw
+			if (rootNode.proof == MCTS_Proof::DRAW && child.proof == MCTS_Proof::DRAW)
+			{
+				return index;
+			}
+
+			if (bestIndex != -1 && child.proof == MCTS_Proof::ROOT_LOSS)
+			{
+				continue;
+			}
+
+			if (bestIndex == -1 || m_StatTree[bestIndex].proof == MCTS_Proof::ROOT_LOSS || child.simReward > m_StatTree[bestIndex].simReward)
+			{
+				bestIndex = index;
+			}
+		}
+
+		return bestIndex == -1 ? 1 : bestIndex;
+	}
+
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::reportAnalysis()
+	{
+		m_Settings.analysis(getPVLines(std::max(1, m_Settings.multiPV)));
+	}
+
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::reportProgress()
+	{
+		auto elapsed = std::chrono::steady_clock::now() - m_SearchStart;
+		double seconds = std::chrono::duration<double>(elapsed).count();
+
+		MCTS_Progress progress;
+		progress.bestMove = m_StatTree[bestRootChild()].move;
+		progress.visits = m_StatTree[0].visits + 1;
+		progress.playouts = m_Playouts - m_SearchPlayouts;
+		progress.playoutsPerSecond = seconds > 0 ? progress.playouts / seconds : 0;
+		progress.milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+		progress.cycles = m_SearchCycles;
+		progress.treeFull = m_TreeFull;
+		m_Settings.progress(progress);
+	}
+
+	// Rank the root moves the way bestRootChild() picks them: proven wins
+	// first, proven losses last and everything else by reward. Each line
+	// then follows the most visited child, whoever is choosing.
+	template <typename Policies>
+	std::vector<MCTS_PVLine> MCTS_BasicEvaluator<Policies>::getPVLines(int count) const
+	{
+		std::vector<MCTS_PVLine> lines;
+		if (m_FreeIndex == 0)
+		{
+			return lines;
+		}
+
+		auto proofRank = [](MCTS_Proof proof)
+		{
+			return proof == MCTS_Proof::ROOT_WIN ? 0 : proof == MCTS_Proof::ROOT_LOSS ? 2 : 1;
+		};
+
+		std::vector<int> ranked = m_StatTree[0].childIndices;
+		std::sort(ranked.begin(), ranked.end(), [&](int a, int b)
+		{
+			const MCTS_Node& nodeA = m_StatTree[a];
+			const MCTS_Node& nodeB = m_StatTree[b];
+			if (proofRank(nodeA.proof) != proofRank(nodeB.proof))
+			{
+				return proofRank(nodeA.proof) < proofRank(nodeB.proof);
+			}
+
+			return nodeA.simReward > nodeB.simReward;
+		});
+
+		for (int i = 0; i < count && i < ranked.size(); i++)
+		{
+			const MCTS_Node& child = m_StatTree[ranked[i]];
+			MCTS_PVLine line;
+			line.move = child.move;
+			line.visits = child.visits + 1;
+			line.value = child.simReward / (child.visits + 1);
+			line.proof = child.proof;
+
+			int nodeIndex = ranked[i];
+			while (nodeIndex != -1)
+			{
+				const MCTS_Node& node = m_StatTree[nodeIndex];
+				line.pv.push_back(node.move);
+
+				nodeIndex = -1;
+				for (auto const index : node.childIndices)
+				{
+					if (nodeIndex == -1 || m_StatTree[index].visits > m_StatTree[nodeIndex].visits)
+					{
+						nodeIndex = index;
+					}
+				}
+
+				// Stop once the line is down to guesses
+				if (nodeIndex != -1 && m_StatTree[nodeIndex].visits == 0)
+				{
+					nodeIndex = -1;
+				}
+			}
+
+			lines.push_back(line);
+		}
+
+		return lines;
+	}
+
+	template <typename Policies>
+	bool MCTS_BasicEvaluator<Policies>::isTreeFull() const
+	{
+		return m_TreeFull;
+	}
+
+	template <typename Policies>
+	std::int64_t MCTS_BasicEvaluator<Policies>::getPlayouts() const
+	{
+		return m_Playouts;
+	}
+
+	template <typename Policies>
+	bool MCTS_BasicEvaluator<Policies>::saveSnapshot(const std::string& path) const
+	{
+		if (m_FreeIndex == 0)
+		{
+			return false;
+		}
+
+		// Renumber the tree breadth first so each node's children are contiguous
+		std::vector<int> order;
+		std::vector<MCTS_SnapshotNode> nodes;
+		order.push_back(0);
+		for (int i = 0; i < order.size(); i++)
+		{
+			const MCTS_Node& node = m_StatTree[order[i]];
+			MCTS_SnapshotNode record;
+			record.firstChild = order.size();
+			record.childCount = node.childIndices.size();
+			record.move = node.move.move();
+			record.visits = node.visits;
+			record.simReward = node.simReward;
+			record.prior = node.prior;
+			record.proof = static_cast<std::uint8_t>(node.proof);
+			nodes.push_back(record);
+
+			for (auto const childIndex : node.childIndices)
+			{
+				order.push_back(childIndex);
+			}
+		}
+
+		return MCTS_TreeSnapshot::write(path, m_RootBoard.hash(), nodes);
+	}
+
+	template <typename Policies>
+	bool MCTS_BasicEvaluator<Policies>::loadSnapshot(const MCTS_TreeSnapshot& snapshot)
+	{
+		if (!snapshot.isOpen() || snapshot.nodeCount() == 0 || snapshot.rootHash() != m_RootBoard.hash())
+		{
+			return false;
+		}
+
+		const MCTS_SnapshotNode* records = snapshot.nodes();
+		m_StatTree[0] = MCTS_Node();
+		m_StatTree[0].parentIndex = -1;
+		m_FreeIndex = 1;
+
+		// Records are breadth first, so walking them in order places every
+		// node's children after it. A node whose children don't all fit
+		// (or aren't in the file) is left as a leaf.
+		for (int i = 0; i < m_FreeIndex; i++)
+		{
+			const MCTS_SnapshotNode& record = records[i];
+
+			// A proof state that doesn't exist means the file is damaged
+			if (record.proof > static_cast<std::uint8_t>(MCTS_Proof::DRAW))
+			{
+				m_FreeIndex = 0;
+				m_WarmStart = false;
+				return false;
+			}
+
+			MCTS_Node& node = m_StatTree[i];
+			node.childIndices.clear();
+			node.visits = record.visits;
+			node.simReward = record.simReward;
+			node.prior = record.prior;
+			node.proof = static_cast<MCTS_Proof>(record.proof);
+
+			int lastChild = record.firstChild + record.childCount;
+			if (record.childCount == 0 || lastChild > snapshot.nodeCount() || lastChild > m_StatTree.size() || record.firstChild != m_FreeIndex)
+			{
+				continue;
+			}
+
+			for (int j = 0; j < record.childCount; j++)
+			{
+				int childIndex = m_FreeIndex;
+				m_FreeIndex++;
+
+				MCTS_Node& child = m_StatTree[childIndex];
+				child = MCTS_Node();
+				child.parentIndex = i;
+				child.depth = node.depth + 1;
+				child.move = chess::Move(records[childIndex].move);
+				node.childIndices.push_back(childIndex);
+			}
+		}
+
+		// An unexpanded root is no head start
+		m_WarmStart = !m_StatTree[0].childIndices.empty();
+		if (!m_WarmStart)
+		{
+			m_FreeIndex = 0;
+		}
+
+		// The last search's flag says nothing about the loaded tree
+		m_TreeFull = m_FreeIndex >= m_StatTree.size();
+		return m_WarmStart;
+	}
+
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::setRoot(const chess::Board& root)
+	{
+		m_RootBoard = root;
+		m_FreeIndex = 0;
+		m_WarmStart = false;
+		m_TreeFull = false;
+	}
+
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::setTables(const EndgameBitbases* bitbases, EvalCache* evalCache, EvalCache* pawnCache)
+	{
+		m_Settings.bitbases = bitbases;
+		m_Settings.evalCache = evalCache;
+		m_Settings.pawnCache = pawnCache;
+	}
+
+	template <typename Policies>
+	bool MCTS_BasicEvaluator<Policies>::advanceRoot(chess::Move move)
+	{
+		chess::Board root = m_RootBoard;
+		root.makeMove(move);
+
+		int newRootIndex = -1;
+		if (m_FreeIndex > 0)
+		{
+			for (auto const index : m_StatTree[0].childIndices)
+			{
+				if (m_StatTree[index].move == move)
+				{
+					newRootIndex = index;
+				}
+			}
+		}
+
+		if (newRootIndex == -1 || m_StatTree[newRootIndex].childIndices.empty())
+		{
+			setRoot(root);
+			return false;
+		}
+
+		// Keep at most half the tree so the next search has room to grow. The most
+		// visited nodes keep their children first, and a node keeps all of them or
+		// none, becoming a leaf again when they don't fit.
+		constexpr int kKeep = -2;
+		m_RemapIndices.assign(m_FreeIndex, -1);
+		m_RemapIndices[newRootIndex] = kKeep;
+		m_KeepQueue.clear();
+		m_KeepQueue.emplace_back(m_StatTree[newRootIndex].visits, newRootIndex);
+
+		int budget = m_StatTree.size() / 2 - 1;
+		while (!m_KeepQueue.empty())
+		{
+			std::pop_heap(m_KeepQueue.begin(), m_KeepQueue.end());
+			int index = m_KeepQueue.back().second;
+			m_KeepQueue.pop_back();
+
+			const std::vector<int>& children = m_StatTree[index].childIndices;
+			if (children.size() > budget)
+			{
+				continue;
+			}
+
+			budget -= children.size();
+			for (auto const childIndex : children)
+			{
+				m_RemapIndices[childIndex] = kKeep;
+				if (!m_StatTree[childIndex].childIndices.empty())
+				{
+					m_KeepQueue.emplace_back(m_StatTree[childIndex].visits, childIndex);
+					std::push_heap(m_KeepQueue.begin(), m_KeepQueue.end());
+				}
+			}
+		}
+
+		// Children are always placed after their parent, so walking the
+		// subtree in index order only ever moves nodes down and renumbers
+		// every parent before its children. Swapping rather than copying
+		// keeps the child vectors' storage around for later expansions.
+		int freeIndex = 0;
+		for (int i = newRootIndex; i < m_FreeIndex; i++)
+		{
+			int parentIndex = m_StatTree[i].parentIndex;
+			if (m_RemapIndices[i] != kKeep)
+			{
+				continue;
+			}
+
+			m_RemapIndices[i] = freeIndex;
+			std::swap(m_StatTree[freeIndex], m_StatTree[i]);
+
+			// Values are from the root's point of view, and the root changed sides
+			MCTS_Node& node = m_StatTree[freeIndex];
+			node.parentIndex = i == newRootIndex ? -1 : m_RemapIndices[parentIndex];
+			node.depth--;
+			node.simReward = -node.simReward;
+			node.amafReward = -node.amafReward;
+			if (node.proof == MCTS_Proof::ROOT_WIN)
+			{
+				node.proof = MCTS_Proof::ROOT_LOSS;
+			}
+
+			else if (node.proof == MCTS_Proof::ROOT_LOSS)
+			{
+				node.proof = MCTS_Proof::ROOT_WIN;
+			}
+
+			node.childIndices.clear();
+			if (node.parentIndex != -1)
+			{
+				m_StatTree[node.parentIndex].childIndices.push_back(freeIndex);
+			}
+
+			freeIndex++;
+		}
+
+		m_RootBoard = root;
+		m_FreeIndex = freeIndex;
+		m_WarmStart = true;
+		m_TreeFull = false;
+		return true;
+	}
+
+	template <typename Policies>
+	std::vector<MCTS_RootStat> MCTS_BasicEvaluator<Policies>::getRootStats() const
+	{
+		std::vector<MCTS_RootStat> stats;
+		if (m_FreeIndex == 0)
+		{
+			return stats;
+		}
+
+		for (auto const index : m_StatTree[0].childIndices)
+		{
+			MCTS_RootStat stat;
+			stat.move = m_StatTree[index].move.move();
+			stat.visits = m_StatTree[index].visits;
+			stat.simReward = m_StatTree[index].simReward;
+			stats.push_back(stat);
+		}
+
+		return stats;
+	}
+
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::cycle()
+	{
+		m_CycleCount++;
+		if (m_Settings.trace)
+		{
+			m_Settings.trace->record(MCTS_TraceEvent::CYCLE_BEGIN, m_CycleCount);
+		}
+
+		// Get a leaf node to rollout and simulate from, walking down from the root
+		int leafNodeIndex = expansion(0);
+
+		// Every move of the node is solved, so there's nothing to expand
+		if (!m_StatTree[leafNodeIndex].childIndices.empty())
+		{
+			backupSolved(leafNodeIndex);
+
+			if (m_Settings.trace)
+			{
+				m_Settings.trace->record(MCTS_TraceEvent::CYCLE_END, m_CycleCount);
+			}
+			return;
+		}
+
+		// Walk the sim board over from the last cycle's leaf
+		seekSimBoard(leafNodeIndex);
+
+		// Generate all possible moves for the given leaf node
+		// This makes the node no longer a leaf
+		if (!m_TreeFull)
+		{
+			rollout(leafNodeIndex);
+		}
+
+		// For each newly generated leaf node, simulate a random game
+		// and backpropagate the results up to the root.
+		if (m_TreeFull)
+		{
+			revisitLeaf(leafNodeIndex);
+		}
+
+		else
+		{
+			simulateChildren(leafNodeIndex);
+		}
+
+		if (m_Settings.trace)
+		{
+			m_Settings.trace->record(MCTS_TraceEvent::CYCLE_END, m_CycleCount);
+		}
+	}
+
+	// Value a leaf again when the tree has no room left to expand it, so
+	// searches keep refining the values they have until they're stopped
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::revisitLeaf(int leafIndex)
+	{
+		if (leafIndex == 0)
+		{
+			return;
+		}
+
+		seekSimBoard(m_StatTree[leafIndex].parentIndex);
+		float simResult = simulation(leafIndex);
+		update(leafIndex, simResult);
+	}
+
+	// Simulate every child of a freshly expanded node and backpropagate the
+	// results. SimBoard must be at the node's position. With several workers
+	// or playouts per child, the playouts are spread over the worker pool and
+	// each child is backed up once with the mean of its playouts. A stop
+	// request skips the children and playouts that haven't started yet.
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::simulateChildren(int nodeIndex)
+	{
+		const std::vector<int>& children = m_StatTree[nodeIndex].childIndices;
+		int playoutsPerChild = std::max(1, m_Settings.playoutsPerChild);
+
+		// Evaluations give the same value every time, so there's nothing to spread
+		bool evaluated = m_Nnue || LeafEvalPolicy::mode(m_Settings) == MCTS_LeafEval::STATIC;
+		if (evaluated || (!m_Pool && playoutsPerChild == 1))
+		{
+			for (int i = 0; i < children.size() && !m_Stop.stop_requested(); i++)
+			{
+				float simResult = simulation(children[i]);
+				update(children[i], simResult);
+			}
+			return;
+		}
+
+		// Decided positions are valued here, the rest become playout tasks
+		m_TaskNodes.clear();
+		for (auto const childIndex : children)
+		{
+			chess::Move move = m_StatTree[childIndex].move;
+			m_SimBoard.makeMove(move);
+
+			float simResult = 0;
+			bool proven = false;
+			bool exact = genExactVal(m_SimBoard, simResult, &proven);
+			m_SimBoard.unmakeMove(move);
+
+			if (exact)
+			{
+				if (m_Settings.solver && proven)
+				{
+					proveExact(childIndex, simResult);
+				}
+				update(childIndex, simResult);
+				continue;
+			}
+
+			m_TaskNodes.push_back(childIndex);
+		}
+
+		// Tasks skipped after a stop keep a NaN result
+		int taskCount = m_TaskNodes.size() * playoutsPerChild;
+		m_TaskResults.assign(taskCount, std::numeric_limits<float>::quiet_NaN());
+
+		// Each task records its moves in its own list, which keeps their storage
+		// between expansions. They're merged into the RAVE sets at the backup.
+		if (m_Settings.rave && m_TaskMoves.size() < taskCount)
+		{
+			m_TaskMoves.resize(taskCount);
+		}
+
+		// Workers only read SimBoard, each restores its own board from it
+		auto task = [&](int index, int worker)
+		{
+			if (m_Stop.stop_requested())
+			{
+				return;
+			}
+
+			chess::Board& board = m_WorkerBoards[worker];
+			board = m_SimBoard;
+			board.makeMove(m_StatTree[m_TaskNodes[index / playoutsPerChild]].move);
+
+			std::vector<std::uint16_t>* moves = nullptr;
+			if (m_Settings.rave)
+			{
+				moves = &m_TaskMoves[index];
+				moves->clear();
+			}
+
+			int plies = 0;
+			m_TaskResults[index] = playout(board, m_WorkerRngs[worker], moves, &plies);
+
+			if (m_Settings.trace)
+			{
+				m_Settings.trace->record(MCTS_TraceEvent::PLAYOUT, m_TaskNodes[index / playoutsPerChild], plies, m_TaskResults[index]);
+			}
+		};
+
+		if (m_Pool)
+		{
+			m_Pool->run(taskCount, task);
+		}
+
+		else
+		{
+			for (int i = 0; i < taskCount; i++)
+			{
+				task(i, 0);
+			}
+		}
+		// Each child is credited with the moves of all of its playouts,
+		// and children whose playouts were all skipped stay unvalued
+		for (int i = 0; i < m_TaskNodes.size(); i++)
+		{
+			if (m_Settings.rave)
+			{
+				m_AmafMoves.clear();
+			}
+
+			float total = 0;
+			int played = 0;
+			for (int j = 0; j < playoutsPerChild; j++)
+			{
+				int index = i * playoutsPerChild + j;
+				if (std::isnan(m_TaskResults[index]))
+				{
+					continue;
+				}
+
+				total += m_TaskResults[index];
+				played++;
+				if (m_Settings.rave)
+				{
+					addAmafMoves(m_TaskMoves[index], m_StatTree[m_TaskNodes[i]].depth);
+				}
+			}
+
+			m_Playouts += played;
+			if (played > 0)
+			{
+				update(m_TaskNodes[i], total / played);
+			}
+		}
+	}
+
+	// Gather leaves from several selections and value them together.
+	// Returns the number of selections made, each counting as a cycle.
+	template <typename Policies>
+	int MCTS_BasicEvaluator<Policies>::batchCycle(int maxExpansions)
+	{
+		int expansions = 0;
+		while (expansions < maxExpansions && m_BatchNodes.size() < m_Settings.batchSize && !m_Stop.stop_requested())
+		{
+			m_CycleCount++;
+			if (m_Settings.trace)
+			{
+				m_Settings.trace->record(MCTS_TraceEvent::CYCLE_BEGIN, m_CycleCount);
+			}
+
+			int leafNodeIndex = expansion(0);
+			expansions++;
+
+			// Virtual loss couldn't steer selection away from the leaves
+			// already queued, so value what we have first
+			if (m_StatTree[leafNodeIndex].pending)
+			{
+				break;
+			}
+
+			if (!m_StatTree[leafNodeIndex].childIndices.empty())
+			{
+				backupSolved(leafNodeIndex);
+
+				if (m_Settings.trace)
+				{
+					m_Settings.trace->record(MCTS_TraceEvent::CYCLE_END, m_CycleCount);
+				}
+				continue;
+			}
+
+			seekSimBoard(leafNodeIndex);
+			if (!m_TreeFull)
+			{
+				rollout(leafNodeIndex);
+			}
+
+			// Out of nodes, so the leaf itself is valued again
+			if (m_TreeFull && leafNodeIndex != 0)
+			{
+				if (m_Settings.rave)
+				{
+					m_AmafMoves.clear();
+				}
+
+				seekSimBoard(m_StatTree[leafNodeIndex].parentIndex);
+				queueLeaf(leafNodeIndex);
+			}
+
+			else
+			{
+				queueChildren(leafNodeIndex);
+			}
+
+			if (m_Settings.trace)
+			{
+				m_Settings.trace->record(MCTS_TraceEvent::CYCLE_END, m_CycleCount);
+			}
+		}
+
+		flushBatch();
+		return expansions;
+	}
+
+	// Queue the children of a freshly expanded node for batch evaluation.
+	// SimBoard must be at the node's position. Finished games and bitbase
+	// positions are valued straight away.
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::queueChildren(int nodeIndex)
+	{
+		// Batched leaves have no playout moves to credit
+		if (m_Settings.rave)
+		{
+			m_AmafMoves.clear();
+		}
+
+		for (auto const childIndex : m_StatTree[nodeIndex].childIndices)
+		{
+			queueLeaf(childIndex);
+		}
+	}
+
+	// Queue one leaf for batch evaluation, or value it straight away when its
+	// result is known. SimBoard must be at the leaf's parent.
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::queueLeaf(int leafIndex)
+	{
+		chess::Move move = m_StatTree[leafIndex].move;
+		m_SimBoard.makeMove(move);
+
+		float simResult = 0;
+		bool proven = false;
+		if (genExactVal(m_SimBoard, simResult, &proven))
+		{
+			m_SimBoard.unmakeMove(move);
+			if (m_Settings.solver && proven)
+			{
+				proveExact(leafIndex, simResult);
+			}
+			update(leafIndex, simResult);
+			return;
+		}
+
+		// Boards from earlier batches are assigned over, which reuses their storage
+		int slot = m_BatchNodes.size();
+		if (slot < m_BatchBoards.size())
+		{
+			m_BatchBoards[slot] = m_SimBoard;
+		}
+
+		else
+		{
+			m_BatchBoards.push_back(m_SimBoard);
+		}
+		m_SimBoard.unmakeMove(move);
+
+		m_StatTree[leafIndex].pending = true;
+		applyVirtualLoss(leafIndex, 1);
+		m_BatchNodes.push_back(leafIndex);
+	}
+
+	// Value every queued leaf in fixed-size batches, then take
+	// back the virtual losses and backpropagate the real values
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::flushBatch()
+	{
+		int count = m_BatchNodes.size();
+		if (count == 0)
+		{
+			return;
+		}
+
+		m_BatchValues.resize(count);
+		int batchSize = std::max(1, m_Settings.batchSize);
+		for (int start = 0; start < count; start += batchSize)
+		{
+			int size = std::min(batchSize, count - start);
+			m_Settings.batchEvaluator->evaluateBatch(&m_BatchBoards[start], size, &m_BatchValues[start]);
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			int nodeIndex = m_BatchNodes[i];
+			applyVirtualLoss(nodeIndex, -1);
+			m_StatTree[nodeIndex].pending = false;
+
+			// Values come from the side to move at the leaf
+			float simResult = m_BatchValues[i];
+			if (m_BatchBoards[i].sideToMove() != m_RootBoard.sideToMove())
+			{
+				simResult = -simResult;
+			}
+			update(nodeIndex, simResult);
+		}
+
+		// The boards stay for the next batch to assign over
+		m_BatchNodes.clear();
+	}
+
+	// Add (sign 1) or remove (sign -1) a virtual visit and loss on every
+	// node from a leaf up to the root
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::applyVirtualLoss(int nodeIndex, int sign)
+	{
+		int currentIndex = nodeIndex;
+		while (currentIndex != -1)
+		{
+			MCTS_Node& node = m_StatTree[currentIndex];
+			node.visits += sign;
+
+			// The loss is for whoever chose the node. PUCT reads opponent
+			// nodes' rewards flipped, plain UCT reads them all from the root.
+			float loss = m_Settings.virtualLoss;
+			if (SelectionPolicy::choosersView(m_Settings) && node.depth % 2 == 0)
+			{
+				loss = -loss;
+			}
+			node.simReward -= sign * loss;
+
+			currentIndex = node.parentIndex;
+		}
+	}
+
+	// Select the index of the highest UCT
+	template <typename Policies>
+	int MCTS_BasicEvaluator<Policies>::selection(int nodeIndex)
+	{
+		// Select the child node with the highest
+		// UCT from the root game state to expand from
+		MCTS_Node& node = m_StatTree[nodeIndex];
+		int bestIndex = -1;
+		float bestVal = 0;
+
+		for (int i = 0; i < node.childIndices.size(); i++)
+		{
+			int currentIndex = node.childIndices[i];
+
+			// Solved subtrees don't need any more playouts
+			if (m_Settings.solver && m_StatTree[currentIndex].proof != MCTS_Proof::NONE)
+			{
+				continue;
+			}
+
+			float currentVal = genSelectionVal(m_StatTree[currentIndex]);
+
+			if (bestIndex == -1 || currentVal > bestVal)
+			{
+				bestIndex = currentIndex;
+				bestVal = currentVal;
+			}
+
+		}
+
+		// Every child is solved while the node isn't, because the expansion
+		// policy left moves out, so there's nothing to select
+		if (bestIndex == -1)
+		{
+			return -1;
+		}
+
+		if (m_Settings.trace)
+		{
+			m_Settings.trace->record(MCTS_TraceEvent::SELECT, bestIndex, m_StatTree[bestIndex].depth);
+		}
+
+		return bestIndex;
+	}
+
+	// Move SimBoard from the node it's at to another node. It's unmade up to
+	// the nodes' common ancestor and made down from there, so consecutive
+	// cycles, whose paths mostly share their start, only pay for where they
+	// differ rather than replaying the whole path from the root.
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::seekSimBoard(int nodeIndex)
+	{
+		int fromIndex = m_SimIndex;
+		int toIndex = nodeIndex;
+		m_SeekMoves.clear();
+
+		while (m_StatTree[fromIndex].depth > m_StatTree[toIndex].depth)
+		{
+			m_SimBoard.unmakeMove(m_StatTree[fromIndex].move);
+			fromIndex = m_StatTree[fromIndex].parentIndex;
+		}
+
+		while (m_StatTree[toIndex].depth > m_StatTree[fromIndex].depth)
+		{
+			m_SeekMoves.push_back(m_StatTree[toIndex].move);
+			toIndex = m_StatTree[toIndex].parentIndex;
+		}
+
+		while (fromIndex != toIndex)
+		{
+			m_SimBoard.unmakeMove(m_StatTree[fromIndex].move);
+			fromIndex = m_StatTree[fromIndex].parentIndex;
+			m_SeekMoves.push_back(m_StatTree[toIndex].move);
+			toIndex = m_StatTree[toIndex].parentIndex;
+		}
+
+		for (int i = m_SeekMoves.size() - 1; i >= 0; i--)
+		{
+			m_SimBoard.makeMove(m_SeekMoves[i]);
+		}
+		m_SimIndex = nodeIndex;
+	}
+
+	// Find the leaf node with the best UCT from a given node. Stops early at
+	// a node whose children are all solved (see backupSolved).
+	template <typename Policies>
+	int MCTS_BasicEvaluator<Policies>::expansion(int nodeIndex)
+	{
+		// Traverse through each of this node's
+		// child nodes until a leaf node is found
+		int currentIndex = nodeIndex;
+		while (m_StatTree[currentIndex].childIndices.size() != 0)
+		{
+			// Pick the child node with the highest UCT
+			int childIndex = selection(currentIndex);
+			if (childIndex == -1)
+			{
+				break;
+			}
+			currentIndex = childIndex;
+		}
+
+		return currentIndex;
+	}
+
+	// Back up the value of a node whose children are all solved but which isn't
+	// solved itself, since the expansion policy left moves out. Searching below
+	// it can't tell anything new, so it's worth its best solved move for the
+	// side choosing there, like a finished game is worth its result.
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::backupSolved(int nodeIndex)
+	{
+		const MCTS_Node& node = m_StatTree[nodeIndex];
+		bool rootChooses = node.depth % 2 == 0;
+
+		float best = rootChooses ? -1.0f : 1.0f;
+		for (auto const index : node.childIndices)
+		{
+			MCTS_Proof proof = m_StatTree[index].proof;
+			float value = proof == MCTS_Proof::ROOT_WIN ? 1.0f : proof == MCTS_Proof::ROOT_LOSS ? -1.0f : 0.0f;
+			best = rootChooses ? std::max(best, value) : std::min(best, value);
+		}
+
+		// No playout moves to credit
+		if (m_Settings.rave)
+		{
+			m_AmafMoves.clear();
+		}
+
+		update(nodeIndex, best);
+	}
+
+	// Generate all possible moves for a leaf node and add them as children
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::rollout(int leafIndex)
+	{
+		// Generate all moves for the current leaf
+		// Won't work if SimBoard wasn't properly moved
+		// to the leaf by seekSimBoard().
+		MCTS_Node& expandedNode = m_StatTree[leafIndex];
+		expandedNode.childIndices.clear();
+
+		chess::Movelist moves;
+		chess::movegen::legalmoves(moves, m_SimBoard);
+		ExpansionPolicy::filter(m_SimBoard, moves);
+
+		// Stop growing the tree once it's out of nodes
+		if (m_FreeIndex + moves.size() > m_StatTree.size())
+		{
+			m_TreeFull = true;
+			return;
+		}
+
+		// For each possible move
+		for (auto const& move : moves)
+		{
+			// Gen new node using unused node from stat tree
+			int newNodeIndex = m_FreeIndex;
+			MCTS_Node& newNode = m_StatTree[newNodeIndex];
+			m_FreeIndex++;
+
+			newNode.parentIndex = leafIndex;
+			newNode.childIndices.clear();
+			newNode.move = move;
+			newNode.visits = 0;
+			newNode.simReward = 0;
+			newNode.depth = expandedNode.depth + 1;
+			newNode.prior = 0;
+			newNode.amafVisits = 0;
+			newNode.amafReward = 0;
+			newNode.proof = MCTS_Proof::NONE;
+			newNode.pending = false;
+
+			expandedNode.childIndices.push_back(newNodeIndex);
+		}
+
+		if (m_Settings.trace)
+		{
+			m_Settings.trace->record(MCTS_TraceEvent::EXPAND, leafIndex, moves.size());
+		}
+
+		if (SelectionPolicy::usesPriors(m_Settings))
+		{
+			genPriors(leafIndex);
+		}
+	}
+
+	// Give each child of a freshly expanded node a prior from cheap move
+	// heuristics. SimBoard must be at the node's position.
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::genPriors(int nodeIndex)
+	{
+		MCTS_Node& node = m_StatTree[nodeIndex];
+		if (node.childIndices.empty())
+		{
+			return;
+		}
+
+		// Softmax over the move scores, shifted by the best
+		// score to keep the exponentials in range
+		std::vector<float> scores;
+		float bestScore = -1e9f;
+		for (auto const index : node.childIndices)
+		{
+			float score = scoreMove(m_SimBoard, m_StatTree[index].move) / m_Settings.priorTemperature;
+			scores.push_back(score);
+			bestScore = std::max(bestScore, score);
+		}
+
+		float total = 0;
+		for (auto& score : scores)
+		{
+			score = std::exp(score - bestScore);
+			total += score;
+		}
+
+		for (int i = 0; i < node.childIndices.size(); i++)
+		{
+			m_StatTree[node.childIndices[i]].prior = scores[i] / total;
+		}
+	}
+
+	// Simulate from the leaf's state and return the endgame result
+	template <typename Policies>
+	float MCTS_BasicEvaluator<Policies>::simulation(int leafIndex)
+	{
+		if (m_Nnue)
+		{
+			return networkValue(leafIndex);
+		}
+
+		chess::Move move = m_StatTree[leafIndex].move;
+		if (LeafEvalPolicy::mode(m_Settings) == MCTS_LeafEval::STATIC)
+		{
+			if (m_Settings.rave)
+			{
+				m_AmafMoves.clear();
+			}
+
+			m_SimBoard.makeMove(move);
+			float value = 0;
+			bool proven = false;
+			if (!genExactVal(m_SimBoard, value, &proven))
+			{
+				value = genStateVal(m_SimBoard);
+			}
+			m_SimBoard.unmakeMove(move);
+
+			if (m_Settings.solver && proven)
+			{
+				proveExact(leafIndex, value);
+			}
+			return value;
+		}
+
+		// The playout board is restored from SimBoard by assignment, which reuses its storage
+		chess::Board& leafBoard = m_WorkerBoards[0];
+		leafBoard = m_SimBoard;
+		leafBoard.makeMove(move);
+
+		int plies = 0;
+		m_PlayoutMoves.clear();
+		float simResult = playout(leafBoard, m_Rng, m_Settings.rave ? &m_PlayoutMoves : nullptr, &plies);
+		m_Playouts++;
+
+		// Track who played what for the RAVE update
+		if (m_Settings.rave)
+		{
+			m_AmafMoves.clear();
+			addAmafMoves(m_PlayoutMoves, m_StatTree[leafIndex].depth);
+		}
+
+		if (m_Settings.trace)
+		{
+			m_Settings.trace->record(MCTS_TraceEvent::PLAYOUT, leafIndex, plies, simResult);
+		}
+
+		// A node whose game is already over is solved. Bitbase
+		// hits end playouts too, but they only value the node.
+		if (m_Settings.solver && plies == 0 && leafBoard.isGameOver().first != chess::GameResultReason::NONE)
+		{
+			proveExact(leafIndex, simResult);
+		}
+
+		return simResult;
+	}
+
+	// Play a game out from a board and return the result from the root's
+	// side. Only touches its arguments, so pool workers can run it at once.
+	// The moves played are appended to moves, and plies is set to their number.
+	template <typename Policies>
+	float MCTS_BasicEvaluator<Policies>::playout(chess::Board& board, std::mt19937& rng, std::vector<std::uint16_t>* moves, int* plies) const
+	{
+		int played = 0;
+
+		// Simulate a random game until an end state is hit,
+		// or a position whose result is known
+		float simResult = 0;
+		bool endState = false;
+		while (!endState)
+		{
+			if (genExactVal(board, simResult))
+			{
+				endState = true; continue;
+			}
+
+			chess::Movelist legalMoves;
+			chess::movegen::legalmoves(legalMoves, board);
+
+			chess::Move move = PlayoutPolicy::pick(board, legalMoves, rng, m_Settings);
+			board.makeMove(move);
+
+			played++;
+			if (moves)
+			{
+				moves->push_back(move.move());
+			}
+		}
+
+		if (plies)
+		{
+			*plies = played;
+		}
+
+		return simResult;
+	}
+
+	// Add the moves of a playout from a node at depth ply to the RAVE sets,
+	// by the parity of the ply each move leads to
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::addAmafMoves(const std::vector<std::uint16_t>& moves, int ply)
+	{
+		for (int i = 0; i < moves.size(); i++)
+		{
+			m_AmafMoves.add((ply + i + 1) % 2, moves[i]);
+		}
+	}
+
+	// Value a leaf with the network instead of playing it out. The
+	// accumulators follow SimBoard, which sits at the leaf's parent, so
+	// each child only costs an incremental update.
+	template <typename Policies>
+	float MCTS_BasicEvaluator<Policies>::networkValue(int leafIndex)
+	{
+		if (m_SimBoard.hash() != m_NnueHash)
+		{
+			m_Nnue->refresh(m_SimBoard);
+			m_NnueHash = m_SimBoard.hash();
+		}
+
+		// No playout moves to credit
+		if (m_Settings.rave)
+		{
+			m_AmafMoves.clear();
+		}
+
+		chess::Move move = m_StatTree[leafIndex].move;
+		m_Nnue->makeMove(m_SimBoard, move);
+
+		float value = 0;
+		bool proven = false;
+		if (genExactVal(m_SimBoard, value, &proven))
+		{
+			if (m_Settings.solver && proven)
+			{
+				proveExact(leafIndex, value);
+			}
+		}
+
+		else
+		{
+			// Cached values are the network's centipawns for the side to move
+			std::uint64_t key = m_SimBoard.hash() ^ m_NetworkSalt;
+			float eval = 0;
+			if (!m_Settings.evalCache || !m_Settings.evalCache->probe(key, eval))
+			{
+				eval = m_Nnue->evaluate(m_SimBoard);
+				if (m_Settings.evalCache)
+				{
+					m_Settings.evalCache->store(key, eval);
+				}
+			}
+
+			// Squash centipawns into a reward from the root's side
+			value = std::tanh(eval / 400.0f);
+			if (m_SimBoard.sideToMove() != m_RootBoard.sideToMove())
+			{
+				value = -value;
+			}
+		}
+
+		m_Nnue->unmakeMove(m_SimBoard, move);
+		return value;
+	}
+
+	// Reward of a finished game from the root's side
+	template <typename Policies>
+	float MCTS_BasicEvaluator<Policies>::genResultVal(const chess::Board& board) const
+	{
+		float simResult = 0;
+
+
+		if (board.isGameOver().second == chess::GameResult::LOSE)
+		{
+			if (board.sideToMove() == m_RootBoard.sideToMove())
+			{
+				simResult = -1;
+			}
+
+			else if (board.sideToMove() != m_RootBoard.sideToMove())
+			{
+				simResult = 1;
+			}
+		}
+
+		else if (board.isGameOver().second == chess::GameResult::DRAW)
+		{
+			//simResult = genStateVal(board);
+
+			if (m_RootBoard.sideToMove() == chess::Color::BLACK)
+			{
+				//simResult *= -1;
+			}
+		}
+
+		return simResult;
+	}
+
+	// Value of a position from the root's side, if it's known:
+	// the game is over or the position is covered by the bitbases
+	template <typename Policies>
+	bool MCTS_BasicEvaluator<Policies>::genExactVal(const chess::Board& board, float& simResult, bool* proven) const
+	{
+		if (board.isGameOver().first != chess::GameResultReason::NONE)
+		{
+			simResult = genResultVal(board);
+			if (proven)
+			{
+				*proven = true;
+			}
+			return true;
+		}
+
+		// Bitbases don't know the fifty-move rule, so a win is only
+		// trusted while there's room left on the clock to mate
+		BitbaseResult result;
+		if (m_Settings.bitbases && m_Settings.bitbases->probe(board, result))
+		{
+			if (result != BitbaseResult::DRAW && board.halfMoveClock() > MCTS_BITBASE_MAX_CLOCK)
+			{
+				return false;
+			}
+
+			simResult = genBitbaseVal(board, result);
+			return true;
+		}
+
+		return false;
+	}
+
+	// Value of a bitbase hit from the root's side. A win is worth less than a mate
+	// and more the nearer it is to one, so the search heads for the mate rather than
+	// shuffling between won positions: with a piece, the weaker king on the edge and
+	// the kings close, with a pawn, the pawn further up.
+	template <typename Policies>
+	float MCTS_BasicEvaluator<Policies>::genBitbaseVal(const chess::Board& board, BitbaseResult result) const
+	{
+		if (result == BitbaseResult::DRAW)
+		{
+			return 0;
+		}
+
+		chess::Color strong = result == BitbaseResult::WIN ? board.sideToMove() : ~board.sideToMove();
+		chess::Square strongKing = board.kingSq(strong);
+		chess::Square weakKing = board.kingSq(~strong);
+
+		float value = 0;
+		chess::Bitboard pawns = board.pieces(chess::PieceType::PAWN, strong);
+		if (!pawns.empty())
+		{
+			int rank = chess::Square(pawns.lsb()).rank();
+			int advance = strong == chess::Color::WHITE ? rank - 1 : 6 - rank;
+			value = 0.7f + 0.02f * advance;
+		}
+
+		else
+		{
+			int file = weakKing.file();
+			int rank = weakKing.rank();
+			int edge = std::max(3 - file, file - 4) + std::max(3 - rank, rank - 4);
+			int distance = std::max(std::abs(int(strongKing.file()) - file), std::abs(int(strongKing.rank()) - rank));
+			value = 0.8f + 0.15f * (edge + 7 - distance) / 12.0f;
+		}
+
+		return strong == m_RootBoard.sideToMove() ? value : -value;
+	}
+
+	// Prove a leaf from its exact value
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::proveExact(int leafIndex, float simResult)
+	{
+		if (simResult > 0)
+		{
+			prove(leafIndex, MCTS_Proof::ROOT_WIN);
+		}
+
+		else if (simResult < 0)
+		{
+			prove(leafIndex, MCTS_Proof::ROOT_LOSS);
+		}
+
+		else
+		{
+			prove(leafIndex, MCTS_Proof::DRAW);
+		}
+	}
+
+	// Backpropagate up the tree from a node until the root is hit
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::update(int nodeIndex, float simResult)
+	{
+		int currentIndex = nodeIndex;
+		//m_StatTree[nodeIndex].visits++;
+
+		// Backtrack up the tree until the root is hit
+		// (ie. a node w/o a parent)
+		while (currentIndex != -1)
+		{
+			// Update node visit count and sim result
+			m_StatTree[currentIndex].simReward += simResult;
+
+			// Moves on the path count as played for the nodes above them
+			if (m_Settings.rave)
+			{
+				m_AmafMoves.add(m_StatTree[currentIndex].depth % 2, m_StatTree[currentIndex].move.move());
+			}
+
+			// Update current node to parent node
+			int parentIndex = m_StatTree[currentIndex].parentIndex;
+			currentIndex = parentIndex;
+			if (currentIndex == -1)
+			{
+				break;
+			}
+
+			m_StatTree[currentIndex].visits++; // is this wrong?
+			simResult = BackupPolicy::next(simResult);
+
+			if (m_Settings.rave)
+			{
+				updateAmaf(currentIndex, simResult);
+			}
+		}
+	}
+
+	// Mark a node as solved and propagate the proof up the tree for as
+	// long as it settles the value of the parents too
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::prove(int nodeIndex, MCTS_Proof proof)
+	{
+		int currentIndex = nodeIndex;
+		while (currentIndex != -1 && proof != MCTS_Proof::NONE)
+		{
+			m_StatTree[currentIndex].proof = proof;
+
+			currentIndex = m_StatTree[currentIndex].parentIndex;
+			if (currentIndex != -1)
+			{
+				proof = genParentProof(currentIndex);
+			}
+		}
+	}
+
+	// Work out whether a node is solved by its children. The side choosing
+	// at a node wins if any move wins for them, and loses only if every move
+	// loses. Draws need every move to be solved.
+	template <typename Policies>
+	MCTS_Proof MCTS_BasicEvaluator<Policies>::genParentProof(int nodeIndex)
+	{
+		const MCTS_Node& node = m_StatTree[nodeIndex];
+
+		// Nodes at even depths are where the root's side chooses
+		MCTS_Proof chooserWin = node.depth % 2 == 0 ? MCTS_Proof::ROOT_WIN : MCTS_Proof::ROOT_LOSS;
+		MCTS_Proof chooserLoss = node.depth % 2 == 0 ? MCTS_Proof::ROOT_LOSS : MCTS_Proof::ROOT_WIN;
+
+		bool allSolved = true;
+		bool anyDraw = false;
+		for (auto const index : node.childIndices)
+		{
+			MCTS_Proof childProof = m_StatTree[index].proof;
+			if (childProof == chooserWin)
+			{
+				return chooserWin;
+			}
+
+			if (childProof == MCTS_Proof::NONE)
+			{
+				allSolved = false;
+			}
+
+			else if (childProof == MCTS_Proof::DRAW)
+			{
+				anyDraw = true;
+			}
+		}
+
+		// Moves left out at expansion could still hold a way out
+		if (!allSolved || node.childIndices.empty() || !ExpansionPolicy::complete)
+		{
+			return MCTS_Proof::NONE;
+		}
+
+		return anyDraw ? MCTS_Proof::DRAW : chooserLoss;
+	}
+
+	// Credit every child whose move was played later on in the
+	// simulation by the side choosing at this node
+	template <typename Policies>
+	void MCTS_BasicEvaluator<Policies>::updateAmaf(int nodeIndex, float simResult)
+	{
+		const MCTS_Node& node = m_StatTree[nodeIndex];
+		int side = (node.depth + 1) % 2;
+
+		for (auto const index : node.childIndices)
+		{
+			MCTS_Node& child = m_StatTree[index];
+			if (m_AmafMoves.test(side, child.move.move()))
+			{
+				child.amafVisits++;
+				child.amafReward += simResult;
+			}
+		}
+	}
+
+	template <typename Policies>
+	float MCTS_BasicEvaluator<Policies>::genSelectionVal(const MCTS_Node& node)
+	{
+		return SelectionPolicy::value(node, m_StatTree[node.parentIndex], m_Settings);
+	}
+
+	// Static evaluation as a reward from the root's side, squashed the
+	// way the weights were tuned so it reads as an expected result
+	template <typename Policies>
+	float MCTS_BasicEvaluator<Policies>::genStateVal(const chess::Board& board) const
+	{
+		// Cached values are white's centipawns, salted apart from the network's
+		std::uint64_t key = board.hash() ^ m_StaticSalt;
+		float eval = 0;
+		if (!m_Settings.evalCache || !m_Settings.evalCache->probe(key, eval))
+		{
+			std::uint64_t whitePawns = board.pieces(chess::PieceType::PAWN, chess::Color::WHITE).getBits();
+			std::uint64_t blackPawns = board.pieces(chess::PieceType::PAWN, chess::Color::BLACK).getBits();
+			std::uint64_t pawnKey = EvalCache::pawnKey(whitePawns, blackPawns) ^ m_StaticSalt;
+
+			float pawns = 0;
+			if (!m_Settings.pawnCache || !m_Settings.pawnCache->probe(pawnKey, pawns))
+			{
+				pawns = m_EvalWeights.evaluatePawns(whitePawns, blackPawns);
+				if (m_Settings.pawnCache)
+				{
+					m_Settings.pawnCache->store(pawnKey, pawns);
+				}
+			}
+
+			eval = m_EvalWeights.evaluatePieces(board) + pawns;
+			if (m_Settings.evalCache)
+			{
+				m_Settings.evalCache->store(key, eval);
+			}
+		}
+
+		float val = std::tanh(eval / (2 * m_EvalWeights.scale));
+		if (m_RootBoard.sideToMove() == chess::Color::BLACK)
+		{
+			val = -val;
+		}
+
+		return val;
+	}
+}
@@ -0,0 +1,252 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "chess.hpp"
+#include "move-heuristics.h"
+#include "mcts-types.h"
+#include "playout-policy.h"
+
+namespace ChessSimulator {
+	/*
+	* Policies the evaluator is built from (see MCTS_BasicEvaluator).
+	*
+	* - Each policy is a stateless type with static functions, so the evaluator calls
+	*	them directly and the compiler inlines them. Parameters are template arguments.
+	* - The Settings policies read their choice from MCTS_Settings at run time and make
+	*	up the default MCTS_Evaluator. The others fix the choice at compile time.
+	* - Selection: value(node, parent, settings) scores a child for selection,
+	*	usesPriors(settings) says whether expansion has to give children priors and
+	*	choosersView(settings) whether values are from the side choosing at the parent
+	*	rather than the root's side, which virtual loss has to follow.
+	* - Expansion: filter(board, moves) cuts down the moves a node is expanded with.
+	*	complete says whether every legal move is kept, which the solver needs to prove
+	*	a node lost or drawn from its children.
+	* - Playout: pick(board, moves, rng, settings) chooses the next move of a playout.
+	* - Leaf evaluation: mode(settings) says how new leaves are valued.
+	* - Backup: next(result) turns the result backed up into a node into the result
+	*	backed up into its parent.
+	*/
+
+	// Mean reward of a node from the root's side, blended with its RAVE
+	// value by a weight that decays as the node gathers its own samples
+	inline float genExploit(const MCTS_Node& node, float samples, const MCTS_Settings& settings)
+	{
+		float exploit = node.simReward / samples;
+		if (!settings.rave || node.amafVisits == 0)
+		{
+			return exploit;
+		}
+
+		float k = settings.raveEquivalence;
+		float beta = std::sqrt(k / (3 * samples + k));
+		float amafExploit = node.amafReward / node.amafVisits;
+
+		return (1 - beta) * exploit + beta * amafExploit;
+	}
+
+	// UCT: Q + C * sqrt(log(parent visits) / visits)
+	inline float genUCT(const MCTS_Node& node, const MCTS_Node& parent, const MCTS_Settings& settings, float c)
+	{
+		float visits = node.visits + 0.0001;
+		float parentVisits = parent.visits + 0.0001;
+
+		float exploit = genExploit(node, visits, settings);
+		float expansion = std::sqrt(std::log(parentVisits) / visits);
+		return exploit + c * expansion;
+	}
+
+	// PUCT: Q + C * P * sqrt(parent samples) / (1 + samples)
+	inline float genPUCT(const MCTS_Node& node, const MCTS_Node& parent, const MCTS_Settings& settings, float c)
+	{
+		// Every node is simulated once when it's created and its visits only
+		// count backups from below it, so it holds visits + 1 samples.
+		float samples = node.visits + 1.0f;
+		float parentSamples = parent.visits + 1.0f;
+
+		// Rewards are from the root's side, so flip them
+		// for nodes reached by an opponent's move
+		float exploit = genExploit(node, samples, settings);
+		if (node.depth % 2 == 0)
+		{
+			exploit = -exploit;
+		}
+
+		float explore = c * node.prior * std::sqrt(parentSamples) / (1.0f + samples);
+		return exploit + explore;
+	}
+
+	struct MCTS_SettingsSelection
+	{
+		static float value(const MCTS_Node& node, const MCTS_Node& parent, const MCTS_Settings& settings)
+		{
+			if (settings.selection == MCTS_Selection::PUCT)
+			{
+				return genPUCT(node, parent, settings, settings.puctC);
+			}
+
+			return genUCT(node, parent, settings, 1.41421356f);
+		}
+
+		static bool usesPriors(const MCTS_Settings& settings)
+		{
+			return settings.selection == MCTS_Selection::PUCT;
+		}
+
+		static bool choosersView(const MCTS_Settings& settings)
+		{
+			return settings.selection == MCTS_Selection::PUCT;
+		}
+	};
+
+	template <float C = 1.41421356f>
+	struct MCTS_UCTSelection
+	{
+		static float value(const MCTS_Node& node, const MCTS_Node& parent, const MCTS_Settings& settings)
+		{
+			return genUCT(node, parent, settings, C);
+		}
+
+		static constexpr bool usesPriors(const MCTS_Settings&)
+		{
+			return false;
+		}
+
+		static constexpr bool choosersView(const MCTS_Settings&)
+		{
+			return false;
+		}
+	};
+
+	template <float C = 1.5f>
+	struct MCTS_PUCTSelection
+	{
+		static float value(const MCTS_Node& node, const MCTS_Node& parent, const MCTS_Settings& settings)
+		{
+			return genPUCT(node, parent, settings, C);
+		}
+
+		static constexpr bool usesPriors(const MCTS_Settings&)
+		{
+			return true;
+		}
+
+		static constexpr bool choosersView(const MCTS_Settings&)
+		{
+			return true;
+		}
+	};
+
+	// Expand every legal move
+	struct MCTS_FullExpansion
+	{
+		static constexpr bool complete = true;
+
+		static void filter(chess::Board&, chess::Movelist&)
+		{
+		}
+	};
+
+	// Expand only the Width moves the move heuristics like best
+	template <int Width>
+	struct MCTS_WidthExpansion
+	{
+		static constexpr bool complete = false;
+
+		static void filter(chess::Board& board, chess::Movelist& moves)
+		{
+			if (moves.size() <= Width)
+			{
+				return;
+			}
+
+			for (auto& move : moves)
+			{
+				move.setScore(std::clamp(scoreMove(board, move), -32000, 32000));
+			}
+
+			std::partial_sort(moves.begin(), moves.begin() + Width, moves.end(),
+				[](const chess::Move& a, const chess::Move& b) { return a.score() > b.score(); });
+
+			chess::Movelist kept;
+			for (int i = 0; i < Width; i++)
+			{
+				kept.add(moves[i]);
+			}
+			moves = kept;
+		}
+	};
+
+	struct MCTS_SettingsPlayout
+	{
+		static chess::Move pick(chess::Board& board, const chess::Movelist& moves, std::mt19937& rng, const MCTS_Settings& settings)
+		{
+			return pickPlayoutMove(board, moves, settings.playout, settings.playoutTemperature, rng);
+		}
+	};
+
+	struct MCTS_UniformPlayout
+	{
+		static chess::Move pick(chess::Board&, const chess::Movelist& moves, std::mt19937& rng, const MCTS_Settings&)
+		{
+			std::uniform_int_distribution<> moveRange(0, moves.size() - 1);
+			return moves[moveRange(rng)];
+		}
+	};
+
+	template <float Temperature = 100.0f>
+	struct MCTS_HeavyPlayout
+	{
+		static chess::Move pick(chess::Board& board, const chess::Movelist& moves, std::mt19937& rng, const MCTS_Settings&)
+		{
+			return pickPlayoutMove(board, moves, MCTS_Playout::HEAVY, Temperature, rng);
+		}
+	};
+
+	struct MCTS_SettingsLeafEval
+	{
+		static MCTS_LeafEval mode(const MCTS_Settings& settings)
+		{
+			return settings.leafEval;
+		}
+	};
+
+	template <MCTS_LeafEval Mode>
+	struct MCTS_FixedLeafEval
+	{
+		static constexpr MCTS_LeafEval mode(const MCTS_Settings&)
+		{
+			return Mode;
+		}
+	};
+
+	// Every node on the path gets the full result
+	struct MCTS_SumBackup
+	{
+		static constexpr float next(float result)
+		{
+			return result;
+		}
+	};
+
+	// Results shrink by Discount per ply up the tree, so quicker results count for more
+	template <float Discount>
+	struct MCTS_DiscountedBackup
+	{
+		static constexpr float next(float result)
+		{
+			return result * Discount;
+		}
+	};
+
+	template <typename Selection = MCTS_SettingsSelection, typename Expansion = MCTS_FullExpansion, typename Playout = MCTS_SettingsPlayout,
+		typename LeafEval = MCTS_SettingsLeafEval, typename Backup = MCTS_SumBackup>
+	struct MCTS_Policies
+	{
+		using SelectionPolicy = Selection;
+		using ExpansionPolicy = Expansion;
+		using PlayoutPolicy = Playout;
+		using LeafEvalPolicy = LeafEval;
+		using BackupPolicy = Backup;
+	};
+}
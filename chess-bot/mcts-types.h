@@ -0,0 +1,217 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "chess.hpp"
+#include "endgame-bitbase.h"
+#include "eval-cache.h"
+#include "eval-weights.h"
+#include "leaf-evaluator.h"
+#include "nnue.h"
+#include "playout-policy.h"
+#include "trace-recorder.h"
+
+namespace ChessSimulator {
+	// Nodes available to a search by default (see MCTS_Settings::treeSize)
+	constexpr int MCTS_TREE_SIZE = 10000;
+
+	// Game-theoretic value of a node once it's been solved,
+	// from the point of view of the side to move at the root
+	enum class MCTS_Proof
+	{
+		NONE,
+		ROOT_WIN,
+		ROOT_LOSS,
+		DRAW
+	};
+
+	struct MCTS_Node
+	{
+		chess::Move move;
+		int parentIndex = -1;
+		std::vector<int> childIndices;
+
+		int visits = 0;
+		float simReward = 0;
+
+		// Plies from the root. Moves of odd depth nodes are made by the root's side.
+		int depth = 0;
+		// Heuristic probability of the move, set at expansion when PUCT selection is used
+		float prior = 0;
+
+		// All-moves-as-first statistics: playouts from the parent
+		// in which this node's move was played by the same side
+		int amafVisits = 0;
+		float amafReward = 0;
+
+		MCTS_Proof proof = MCTS_Proof::NONE;
+
+		// Queued for batch evaluation and not valued yet
+		bool pending = false;
+	};
+
+	/*
+	* Moves played since the root in a simulation, one set for each side (indexed
+	* by the parity of the ply the move leads to), for the RAVE update. The moves
+	* set are listed as well, so clearing only touches those rather than both
+	* 64K bit sets.
+	*/
+	struct MCTS_AmafMoves
+	{
+		std::bitset<65536> played[2];
+		std::vector<std::uint16_t> listed[2];
+
+		void add(int side, std::uint16_t move)
+		{
+			if (!played[side].test(move))
+			{
+				played[side].set(move);
+				listed[side].push_back(move);
+			}
+		}
+
+		bool test(int side, std::uint16_t move) const
+		{
+			return played[side].test(move);
+		}
+
+		void clear()
+		{
+			for (int side = 0; side < 2; side++)
+			{
+				for (auto const move : listed[side])
+				{
+					played[side].reset(move);
+				}
+				listed[side].clear();
+			}
+		}
+	};
+
+	enum class MCTS_Selection
+	{
+		UCT,	// Plain UCT, every unvisited child looks the same
+		PUCT	// UCT guided by heuristic move priors
+	};
+
+	enum class MCTS_LeafEval
+	{
+		PLAYOUT,	// Play the leaf out to the end of the game
+		NNUE,		// Value the leaf with an NNUE_Network
+		STATIC,		// Value the leaf with the material and piece-square evaluation
+		BATCH		// Queue leaves and value them in batches with an MCTS_LeafEvaluator
+	};
+
+	// One ranked root move of an analysis and the line the search expects after it
+	struct MCTS_PVLine
+	{
+		chess::Move move;
+		int visits = 0;
+		// Mean playout result from the root's point of view, in [-1, 1]
+		float value = 0;
+		MCTS_Proof proof = MCTS_Proof::NONE;
+		// Principal variation starting with move, following the most visited children
+		std::vector<chess::Move> pv;
+	};
+
+	// Snapshot of a running search, handed to MCTS_Settings::progress
+	struct MCTS_Progress
+	{
+		// The move genMove() would return if it stopped now
+		chess::Move bestMove;
+		// Samples of the root, including those kept from earlier searches
+		int visits = 0;
+		// Playouts and cycles run by this genMove() call
+		std::int64_t playouts = 0;
+		int cycles = 0;
+		float playoutsPerSecond = 0;
+		std::int64_t milliseconds = 0;
+		// Whether the tree has run out of nodes and cycles only revisit leaves
+		bool treeFull = false;
+	};
+
+	struct MCTS_Settings
+	{
+		// Nodes the search tree can hold. advanceRoot() keeps at most half of them.
+		int treeSize = MCTS_TREE_SIZE;
+
+		MCTS_Selection selection = MCTS_Selection::UCT;
+
+		// Exploration constant of the PUCT formula
+		float puctC = 1.5f;
+		// Softmax temperature, in centipawns, turning move scores into priors
+		float priorTemperature = 100.0f;
+
+		MCTS_Playout playout = MCTS_Playout::UNIFORM;
+		// Softmax temperature, in centipawns, of the heavy playout policy
+		float playoutTemperature = 100.0f;
+
+		// Blend RAVE (all-moves-as-first) values into selection
+		bool rave = false;
+		// Samples at which a node's own value and its RAVE value weigh the same
+		float raveEquivalence = 1000.0f;
+
+		// Propagate proven wins, losses and draws up the tree and stop searching solved lines
+		bool solver = true;
+
+		MCTS_LeafEval leafEval = MCTS_LeafEval::PLAYOUT;
+		// Network used for NNUE leaf evaluation, it must outlive the evaluator.
+		// Falls back to playouts when it's missing or not loaded.
+		const NNUE_Network* network = nullptr;
+
+		// Weights of the STATIC leaf evaluation, copied by the evaluator.
+		// The built-in piece values are used when it's missing.
+		const EvalWeights* evalWeights = nullptr;
+
+		// Caches of STATIC and NNUE leaf values and of pawn structure terms. They can be
+		// shared by any number of searches and threads, and must outlive the evaluator.
+		EvalCache* evalCache = nullptr;
+		EvalCache* pawnCache = nullptr;
+
+		// Evaluator used for BATCH leaf evaluation, it must outlive the evaluator.
+		// Falls back to playouts when it's missing.
+		MCTS_LeafEvaluator* batchEvaluator = nullptr;
+		// Leaves handed to the batch evaluator at a time
+		int batchSize = 64;
+		// Loss added along the path of each queued leaf so that
+		// the selections gathering a batch spread out
+		float virtualLoss = 1.0f;
+
+		// Threads sharing the playouts of each expansion (leaf parallelism)
+		int threads = 1;
+		// Playouts per new child, averaged into a single backup
+		int playoutsPerChild = 1;
+
+		// Bitbases giving exact results in small endings, in both the tree and playouts.
+		// They must outlive the evaluator.
+		const EndgameBitbases* bitbases = nullptr;
+
+		// Records selection, expansion and playout events of every cycle.
+		// It must outlive the evaluator and is flushed at the end of genMove().
+		MCTS_TraceRecorder* trace = nullptr;
+
+		// Called with the best multiPV root lines every analysisInterval
+		// cycles of genMove() and once more when it finishes
+		std::function<void(const std::vector<MCTS_PVLine>&)> analysis;
+		int multiPV = 1;
+		int analysisInterval = 100;
+
+		// Called about every progressInterval milliseconds
+		// of genMove() and once more when it finishes
+		std::function<void(const MCTS_Progress&)> progress;
+		int progressInterval = 250;
+	};
+
+	/*
+	* Fixed-size statistics for one root move. This is the record searches
+	* exchange when their results are merged (see mcts-ensemble.h), so it
+	* stores the move as its raw 16 bit encoding rather than a chess::Move.
+	*/
+	struct MCTS_RootStat
+	{
+		std::uint16_t move = 0;
+		std::int32_t visits = 0;
+		float simReward = 0;
+	};
+}
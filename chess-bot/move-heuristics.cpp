@@ -0,0 +1,245 @@
+#include "move-heuristics.h"
+#include <algorithm>
+
+using namespace ChessSimulator;
+
+namespace {
+	constexpr int kPieceValues[7] = { 100, 320, 330, 500, 900, 20000, 0 };
+
+	// Bonus for giving check with a move
+	constexpr int kCheckBonus = 50;
+
+	// Piece-square tables from white's point of view, listed from a8 to h1
+	// so they read like a board diagram.
+	constexpr int kPawnTable[64] = {
+		 0,  0,  0,  0,  0,  0,  0,  0,
+		50, 50, 50, 50, 50, 50, 50, 50,
+		10, 10, 20, 30, 30, 20, 10, 10,
+		 5,  5, 10, 25, 25, 10,  5,  5,
+		 0,  0,  0, 20, 20,  0,  0,  0,
+		 5, -5,-10,  0,  0,-10, -5,  5,
+		 5, 10, 10,-20,-20, 10, 10,  5,
+		 0,  0,  0,  0,  0,  0,  0,  0
+	};
+
+	constexpr int kKnightTable[64] = {
+		-50,-40,-30,-30,-30,-30,-40,-50,
+		-40,-20,  0,  0,  0,  0,-20,-40,
+		-30,  0, 10, 15, 15, 10,  0,-30,
+		-30,  5, 15, 20, 20, 15,  5,-30,
+		-30,  0, 15, 20, 20, 15,  0,-30,
+		-30,  5, 10, 15, 15, 10,  5,-30,
+		-40,-20,  0,  5,  5,  0,-20,-40,
+		-50,-40,-30,-30,-30,-30,-40,-50
+	};
+
+	constexpr int kBishopTable[64] = {
+		-20,-10,-10,-10,-10,-10,-10,-20,
+		-10,  0,  0,  0,  0,  0,  0,-10,
+		-10,  0,  5, 10, 10,  5,  0,-10,
+		-10,  5,  5, 10, 10,  5,  5,-10,
+		-10,  0, 10, 10, 10, 10,  0,-10,
+		-10, 10, 10, 10, 10, 10, 10,-10,
+		-10,  5,  0,  0,  0,  0,  5,-10,
+		-20,-10,-10,-10,-10,-10,-10,-20
+	};
+
+	constexpr int kRookTable[64] = {
+		 0,  0,  0,  0,  0,  0,  0,  0,
+		 5, 10, 10, 10, 10, 10, 10,  5,
+		-5,  0,  0,  0,  0,  0,  0, -5,
+		-5,  0,  0,  0,  0,  0,  0, -5,
+		-5,  0,  0,  0,  0,  0,  0, -5,
+		-5,  0,  0,  0,  0,  0,  0, -5,
+		-5,  0,  0,  0,  0,  0,  0, -5,
+		 0,  0,  0,  5,  5,  0,  0,  0
+	};
+
+	constexpr int kQueenTable[64] = {
+		-20,-10,-10, -5, -5,-10,-10,-20,
+		-10,  0,  0,  0,  0,  0,  0,-10,
+		-10,  0,  5,  5,  5,  5,  0,-10,
+		 -5,  0,  5,  5,  5,  5,  0, -5,
+		  0,  0,  5,  5,  5,  5,  0, -5,
+		-10,  5,  5,  5,  5,  5,  0,-10,
+		-10,  0,  5,  0,  0,  0,  0,-10,
+		-20,-10,-10, -5, -5,-10,-10,-20
+	};
+
+	constexpr int kKingTable[64] = {
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-20,-30,-30,-40,-40,-30,-30,-20,
+		-10,-20,-20,-20,-20,-20,-20,-10,
+		 20, 20,  0,  0,  0,  0, 20, 20,
+		 20, 30, 10,  0,  0, 10, 30, 20
+	};
+
+	constexpr const int* kPieceTables[6] = {
+		kPawnTable, kKnightTable, kBishopTable, kRookTable, kQueenTable, kKingTable
+	};
+
+	chess::Bitboard squareBB(chess::Square square)
+	{
+		return chess::Bitboard(1ULL << square.index());
+	}
+
+	// Every piece of either colour attacking a square given an occupancy
+	chess::Bitboard attackersTo(const chess::Board& board, chess::Square square, chess::Bitboard occupied)
+	{
+		chess::Bitboard bishops = board.pieces(chess::PieceType::BISHOP) | board.pieces(chess::PieceType::QUEEN);
+		chess::Bitboard rooks = board.pieces(chess::PieceType::ROOK) | board.pieces(chess::PieceType::QUEEN);
+
+		chess::Bitboard attackers =
+			(chess::attacks::pawn(chess::Color::BLACK, square) & board.pieces(chess::PieceType::PAWN, chess::Color::WHITE)) |
+			(chess::attacks::pawn(chess::Color::WHITE, square) & board.pieces(chess::PieceType::PAWN, chess::Color::BLACK)) |
+			(chess::attacks::knight(square) & board.pieces(chess::PieceType::KNIGHT)) |
+			(chess::attacks::bishop(square, occupied) & bishops) |
+			(chess::attacks::rook(square, occupied) & rooks) |
+			(chess::attacks::king(square) & board.pieces(chess::PieceType::KING));
+
+		return attackers & occupied;
+	}
+}
+
+int ChessSimulator::pieceValue(chess::PieceType type)
+{
+	return kPieceValues[static_cast<int>(type)];
+}
+
+int ChessSimulator::pieceSquareValue(chess::PieceType type, chess::Color color, chess::Square square)
+{
+	if (type == chess::PieceType::NONE)
+	{
+		return 0;
+	}
+
+	// Tables are written from a8, so white squares are flipped vertically
+	int index = square.index();
+	if (color == chess::Color::WHITE)
+	{
+		index ^= 56;
+	}
+
+	return kPieceTables[static_cast<int>(type)][index];
+}
+
+int ChessSimulator::see(const chess::Board& board, chess::Move move)
+{
+	if (move.typeOf() == chess::Move::CASTLING)
+	{
+		return 0;
+	}
+
+	chess::Square from = move.from();
+	chess::Square to = move.to();
+	chess::Bitboard occupied = board.occ() ^ squareBB(from);
+
+	chess::PieceType captured = board.at(to).type();
+	if (move.typeOf() == chess::Move::ENPASSANT)
+	{
+		captured = chess::PieceType::PAWN;
+		occupied = occupied ^ squareBB(board.enpassantSq());
+	}
+
+	// Gains for each capture in the sequence
+	int gain[32];
+	int depth = 0;
+	gain[0] = pieceValue(captured);
+
+	chess::PieceType onSquare = board.at(from).type();
+	if (move.typeOf() == chess::Move::PROMOTION)
+	{
+		onSquare = move.promotionType();
+		gain[0] += pieceValue(onSquare) - pieceValue(chess::PieceType::PAWN);
+	}
+
+	chess::Color side = ~board.sideToMove();
+	while (depth < 31)
+	{
+		chess::Bitboard attackers = attackersTo(board, to, occupied) & board.us(side);
+		if (attackers.empty())
+		{
+			break;
+		}
+
+		// Recapture with the least valuable attacker
+		chess::PieceType attackerType = chess::PieceType::NONE;
+		chess::Square attackerSquare;
+		for (int type = 0; type < 6; type++)
+		{
+			chess::Bitboard candidates = attackers & board.pieces(chess::PieceType(static_cast<chess::PieceType::underlying>(type)), side);
+			if (!candidates.empty())
+			{
+				attackerType = chess::PieceType(static_cast<chess::PieceType::underlying>(type));
+				attackerSquare = chess::Square(candidates.lsb());
+				break;
+			}
+		}
+
+		depth++;
+		gain[depth] = pieceValue(onSquare) - gain[depth - 1];
+		if (std::max(-gain[depth - 1], gain[depth]) < 0)
+		{
+			break;
+		}
+
+		occupied = occupied ^ squareBB(attackerSquare);
+		onSquare = attackerType;
+		side = ~side;
+	}
+
+	// Either side may stop capturing whenever continuing loses material
+	while (depth > 0)
+	{
+		gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+		depth--;
+	}
+
+	return gain[0];
+}
+
+int ChessSimulator::scoreMove(chess::Board& board, chess::Move move)
+{
+	int score = 0;
+	chess::Color us = board.sideToMove();
+	chess::PieceType moving = board.at(move.from()).type();
+
+	// Captures, most valuable victim first, unless they lose material
+	if (board.isCapture(move) && move.typeOf() != chess::Move::CASTLING)
+	{
+		int exchange = see(board, move);
+		if (exchange >= 0)
+		{
+			chess::PieceType victim = move.typeOf() == chess::Move::ENPASSANT ? chess::PieceType::PAWN : board.at(move.to()).type();
+			score += pieceValue(victim) - pieceValue(moving) / 10;
+		}
+
+		else
+		{
+			score += exchange;
+		}
+	}
+
+	if (move.typeOf() == chess::Move::PROMOTION)
+	{
+		score += pieceValue(move.promotionType()) - pieceValue(chess::PieceType::PAWN);
+	}
+
+	// Positional gain of the moved piece
+	if (move.typeOf() != chess::Move::CASTLING)
+	{
+		score += pieceSquareValue(moving, us, move.to()) - pieceSquareValue(moving, us, move.from());
+	}
+
+	board.makeMove(move);
+	if (board.inCheck())
+	{
+		score += kCheckBonus;
+	}
+	board.unmakeMove(move);
+
+	return score;
+}
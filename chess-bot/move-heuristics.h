@@ -0,0 +1,21 @@
+#pragma once
+#include "chess.hpp"
+
+namespace ChessSimulator {
+	/*
+	* Cheap static move heuristics shared by the search.
+	*
+	* - Values are in centipawns from the point of view of the side making the move.
+	* - pieceValue() is the exchange value of a piece, with the king valued high enough
+	*	that trading it is never considered worthwhile.
+	* - see() runs a static exchange on the move's target square and returns the expected
+	*	material balance once all captures there are played out.
+	* - pieceSquareValue() is a simple positional bonus for a piece standing on a square.
+	* - scoreMove() combines captures (MVV-LVA, checked with SEE), promotions, checks and the
+	*	piece-square delta of the move. The board is restored before it returns.
+	*/
+	int pieceValue(chess::PieceType type);
+	int pieceSquareValue(chess::PieceType type, chess::Color color, chess::Square square);
+	int see(const chess::Board& board, chess::Move move);
+	int scoreMove(chess::Board& board, chess::Move move);
+}
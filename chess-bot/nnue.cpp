@@ -0,0 +1,469 @@
+#include "nnue.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+using namespace ChessSimulator;
+
+namespace {
+	constexpr std::uint32_t kMagic = 0x45554E4E; // "NNUE"
+	constexpr std::uint32_t kVersion = 1;
+
+	// Accumulator values are clipped to [0, kActivationMax] before the output layer,
+	// and output weights are stored scaled up by kWeightScale
+	constexpr int kActivationMax = 127;
+	constexpr int kWeightScale = 64;
+	// Centipawns per unit of network output
+	constexpr int kOutputScale = 600;
+	// Past this many changed features a batch accumulator is rebuilt rather than updated
+	constexpr int kMaxUpdateFeatures = 16;
+
+	int featureIndex(chess::Color perspective, chess::Square kingSquare, chess::Piece piece, chess::Square square)
+	{
+		int king = kingSquare.index();
+		int sq = square.index();
+		if (perspective == chess::Color::BLACK)
+		{
+			king ^= 56;
+			sq ^= 56;
+		}
+
+		int pieceIndex = static_cast<int>(piece.type()) * 2 + (piece.color() == perspective ? 0 : 1);
+		return (king * 10 + pieceIndex) * 64 + sq;
+	}
+
+	void addFeature(std::int16_t* acc, const std::int16_t* weights)
+	{
+#if defined(__AVX2__)
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 16)
+		{
+			__m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+			__m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, w));
+		}
+#elif defined(__SSE4_1__)
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 8)
+		{
+			__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+			__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+			_mm_store_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi16(a, w));
+		}
+#else
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i++)
+		{
+			acc[i] += weights[i];
+		}
+#endif
+	}
+
+	void subFeature(std::int16_t* acc, const std::int16_t* weights)
+	{
+#if defined(__AVX2__)
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 16)
+		{
+			__m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+			__m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+			_mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, w));
+		}
+#elif defined(__SSE4_1__)
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 8)
+		{
+			__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+			__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+			_mm_store_si128(reinterpret_cast<__m128i*>(acc + i), _mm_sub_epi16(a, w));
+		}
+#else
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i++)
+		{
+			acc[i] -= weights[i];
+		}
+#endif
+	}
+
+	// Dot product of the clipped accumulator with the output weights
+	std::int32_t clippedDot(const std::int16_t* acc, const std::int16_t* weights)
+	{
+#if defined(__AVX2__)
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i max = _mm256_set1_epi16(kActivationMax);
+		__m256i sum = _mm256_setzero_si256();
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 16)
+		{
+			__m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+			__m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+			a = _mm256_max_epi16(_mm256_min_epi16(a, max), zero);
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, w));
+		}
+
+		__m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0x4E));
+		total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0xB1));
+		return _mm_cvtsi128_si32(total);
+#elif defined(__SSE4_1__)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i max = _mm_set1_epi16(kActivationMax);
+		__m128i sum = _mm_setzero_si128();
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i += 8)
+		{
+			__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+			__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+			a = _mm_max_epi16(_mm_min_epi16(a, max), zero);
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(a, w));
+		}
+
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+		return _mm_cvtsi128_si32(sum);
+#else
+		std::int32_t sum = 0;
+		for (int i = 0; i < NNUE_HALF_DIMENSIONS; i++)
+		{
+			int a = std::clamp<int>(acc[i], 0, kActivationMax);
+			sum += a * weights[i];
+		}
+		return sum;
+#endif
+	}
+
+	template<typename T>
+	void hashValues(std::uint64_t& hash, const std::vector<T>& values)
+	{
+		// FNV-1a over the values' bytes
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values.data());
+		for (size_t i = 0; i < values.size() * sizeof(T); i++)
+		{
+			hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+		}
+	}
+
+	template<typename T>
+	bool readValues(std::ifstream& file, std::vector<T>& values, size_t count)
+	{
+		values.resize(count);
+		file.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+		return file.good();
+	}
+}
+
+bool NNUE_Network::load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	std::uint32_t header[3] = {};
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!file || header[0] != kMagic || header[1] != kVersion || header[2] != NNUE_HALF_DIMENSIONS)
+	{
+		return false;
+	}
+
+	bool ok = readValues(file, m_FeatureBias, NNUE_HALF_DIMENSIONS) &&
+		readValues(file, m_FeatureWeights, static_cast<size_t>(NNUE_FEATURES) * NNUE_HALF_DIMENSIONS);
+	file.read(reinterpret_cast<char*>(&m_OutputBias), sizeof(m_OutputBias));
+	ok = ok && file.good() && readValues(file, m_OutputWeights, 2 * NNUE_HALF_DIMENSIONS);
+
+	if (!ok)
+	{
+		m_FeatureBias.clear();
+		m_FeatureWeights.clear();
+		m_OutputWeights.clear();
+	}
+
+	updateFingerprint();
+	return ok;
+}
+
+void NNUE_Network::randomize(std::uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> small(-8, 8);
+	std::uniform_int_distribution<int> output(-kWeightScale, kWeightScale);
+
+	m_FeatureBias.assign(NNUE_HALF_DIMENSIONS, 0);
+	m_FeatureWeights.resize(static_cast<size_t>(NNUE_FEATURES) * NNUE_HALF_DIMENSIONS);
+	for (auto& weight : m_FeatureWeights)
+	{
+		weight = static_cast<std::int16_t>(small(rng));
+	}
+
+	m_OutputBias = 0;
+	m_OutputWeights.resize(2 * NNUE_HALF_DIMENSIONS);
+	for (auto& weight : m_OutputWeights)
+	{
+		weight = static_cast<std::int16_t>(output(rng));
+	}
+
+	updateFingerprint();
+}
+
+bool NNUE_Network::isLoaded() const
+{
+	return !m_FeatureWeights.empty();
+}
+
+std::uint64_t NNUE_Network::getFingerprint() const
+{
+	return m_Fingerprint;
+}
+
+void NNUE_Network::updateFingerprint()
+{
+	std::uint64_t hash = 0xCBF29CE484222325ull ^ static_cast<std::uint32_t>(m_OutputBias);
+	hashValues(hash, m_FeatureBias);
+	hashValues(hash, m_FeatureWeights);
+	hashValues(hash, m_OutputWeights);
+	m_Fingerprint = hash;
+}
+
+const std::int16_t* NNUE_Network::featureWeights(int feature) const
+{
+	return &m_FeatureWeights[static_cast<size_t>(feature) * NNUE_HALF_DIMENSIONS];
+}
+
+void NNUE_Network::buildPerspective(const chess::Board& board, NNUE_Accumulator& acc, chess::Color perspective) const
+{
+	std::int16_t* values = acc.values[static_cast<int>(perspective)];
+	std::copy(m_FeatureBias.begin(), m_FeatureBias.end(), values);
+
+	chess::Square kingSquare = board.kingSq(perspective);
+	chess::Bitboard pieces = board.occ() & ~board.pieces(chess::PieceType::KING);
+	while (!pieces.empty())
+	{
+		chess::Square square(pieces.pop());
+		addFeature(values, featureWeights(featureIndex(perspective, kingSquare, board.at(square), square)));
+	}
+}
+
+int NNUE_Network::output(const NNUE_Accumulator& acc, chess::Color sideToMove) const
+{
+	int us = static_cast<int>(sideToMove);
+
+	std::int32_t sum = m_OutputBias;
+	sum += clippedDot(acc.values[us], &m_OutputWeights[0]);
+	sum += clippedDot(acc.values[us ^ 1], &m_OutputWeights[NNUE_HALF_DIMENSIONS]);
+
+	return static_cast<int>(static_cast<std::int64_t>(sum) * kOutputScale / (kActivationMax * kWeightScale));
+}
+
+NNUE_Evaluator::NNUE_Evaluator(const NNUE_Network& network)
+	: m_Network(network)
+{
+	m_Stack.resize(64);
+}
+
+void NNUE_Evaluator::refresh(const chess::Board& board)
+{
+	m_Top = 0;
+	m_Network.buildPerspective(board, m_Stack[0], chess::Color::WHITE);
+	m_Network.buildPerspective(board, m_Stack[0], chess::Color::BLACK);
+}
+
+void NNUE_Evaluator::makeMove(chess::Board& board, chess::Move move)
+{
+	if (m_Top + 1 == m_Stack.size())
+	{
+		m_Stack.resize(m_Stack.size() * 2);
+	}
+
+	const NNUE_Accumulator& previous = m_Stack[m_Top];
+	NNUE_Accumulator& next = m_Stack[m_Top + 1];
+	m_Top++;
+
+	chess::Piece moving = board.at(move.from());
+	bool kingMove = moving.type() == chess::PieceType::KING;
+
+	// Collect the pieces leaving and arriving on squares before the board changes.
+	// Kings aren't features, so a king move only changes the pieces around it.
+	chess::Piece removedPieces[2];
+	chess::Square removedSquares[2];
+	int removedCount = 0;
+	chess::Piece addedPiece = chess::Piece::NONE;
+	chess::Square addedSquare;
+
+	if (move.typeOf() == chess::Move::CASTLING)
+	{
+		// Castling moves are encoded as the king taking its own rook
+		bool kingSide = move.to().index() > move.from().index();
+		removedPieces[removedCount] = board.at(move.to());
+		removedSquares[removedCount] = move.to();
+		removedCount++;
+
+		addedPiece = board.at(move.to());
+		addedSquare = chess::Square((move.from().index() & 56) | (kingSide ? 5 : 3));
+	}
+
+	else
+	{
+		if (!kingMove)
+		{
+			removedPieces[removedCount] = moving;
+			removedSquares[removedCount] = move.from();
+			removedCount++;
+
+			addedPiece = moving;
+			addedSquare = move.to();
+			if (move.typeOf() == chess::Move::PROMOTION)
+			{
+				addedPiece = chess::Piece(move.promotionType(), moving.color());
+			}
+		}
+
+		if (move.typeOf() == chess::Move::ENPASSANT)
+		{
+			// The captured pawn sits one rank behind the target square
+			removedSquares[removedCount] = chess::Square(move.to().index() ^ 8);
+			removedPieces[removedCount] = board.at(removedSquares[removedCount]);
+			removedCount++;
+		}
+
+		else if (board.at(move.to()) != chess::Piece::NONE)
+		{
+			removedPieces[removedCount] = board.at(move.to());
+			removedSquares[removedCount] = move.to();
+			removedCount++;
+		}
+	}
+
+	// The moving king's own perspective is rebuilt once the board has changed
+	for (int perspective = 0; perspective < 2; perspective++)
+	{
+		chess::Color color = perspective == 0 ? chess::Color::WHITE : chess::Color::BLACK;
+		if (kingMove && color == moving.color())
+		{
+			continue;
+		}
+
+		chess::Square kingSquare = board.kingSq(color);
+		std::int16_t* values = next.values[perspective];
+		std::copy(previous.values[perspective], previous.values[perspective] + NNUE_HALF_DIMENSIONS, values);
+
+		for (int i = 0; i < removedCount; i++)
+		{
+			subFeature(values, m_Network.featureWeights(featureIndex(color, kingSquare, removedPieces[i], removedSquares[i])));
+		}
+
+		if (addedPiece != chess::Piece::NONE)
+		{
+			addFeature(values, m_Network.featureWeights(featureIndex(color, kingSquare, addedPiece, addedSquare)));
+		}
+	}
+
+	board.makeMove(move);
+
+	if (kingMove)
+	{
+		m_Network.buildPerspective(board, next, moving.color());
+	}
+}
+
+void NNUE_Evaluator::unmakeMove(chess::Board& board, chess::Move move)
+{
+	board.unmakeMove(move);
+	m_Top--;
+}
+
+int NNUE_Evaluator::evaluate(const chess::Board& board) const
+{
+	return m_Network.output(m_Stack[m_Top], board.sideToMove());
+}
+
+NNUE_BatchEvaluator::NNUE_BatchEvaluator(const NNUE_Network& network)
+	: m_Network(network)
+{
+}
+
+void NNUE_BatchEvaluator::evaluateBatch(const chess::Board* boards, int count, float* values)
+{
+	if (m_Accumulators.size() < count)
+	{
+		m_Accumulators.resize(count);
+	}
+
+	// Accumulators first, each from the one before it where that's cheaper
+	for (int i = 0; i < count; i++)
+	{
+		for (auto const perspective : {chess::Color(chess::Color::WHITE), chess::Color(chess::Color::BLACK)})
+		{
+			if (i == 0 || !updatePerspective(boards[i - 1], m_Accumulators[i - 1], boards[i], m_Accumulators[i], perspective))
+			{
+				m_Network.buildPerspective(boards[i], m_Accumulators[i], perspective);
+			}
+		}
+	}
+
+	// Then the output layer over the whole batch, with its weights staying in cache
+	for (int i = 0; i < count; i++)
+	{
+		values[i] = std::tanh(m_Network.output(m_Accumulators[i], boards[i].sideToMove()) / 400.0f);
+	}
+}
+
+// Build a perspective of acc from the accumulator of another board by the features that
+// differ between them. Returns false when the king moved or too much differs to be worth it.
+bool NNUE_BatchEvaluator::updatePerspective(const chess::Board& from, const NNUE_Accumulator& fromAcc, const chess::Board& board,
+	NNUE_Accumulator& acc, chess::Color perspective) const
+{
+	chess::Square kingSquare = board.kingSq(perspective);
+	if (!(kingSquare == from.kingSq(perspective)))
+	{
+		return false;
+	}
+
+	int removed[kMaxUpdateFeatures];
+	int added[kMaxUpdateFeatures];
+	int removedCount = 0;
+	int addedCount = 0;
+	for (auto const color : {chess::Color(chess::Color::WHITE), chess::Color(chess::Color::BLACK)})
+	{
+		for (int type = 0; type < 5; type++)
+		{
+			chess::PieceType pieceType(static_cast<chess::PieceType::underlying>(type));
+			chess::Piece piece(pieceType, color);
+			chess::Bitboard before = from.pieces(pieceType, color);
+			chess::Bitboard after = board.pieces(pieceType, color);
+
+			chess::Bitboard gone = before & ~after;
+			chess::Bitboard came = after & ~before;
+			if (removedCount + gone.count() > kMaxUpdateFeatures || addedCount + came.count() > kMaxUpdateFeatures)
+			{
+				return false;
+			}
+
+			while (!gone.empty())
+			{
+				chess::Square square(gone.pop());
+				removed[removedCount++] = featureIndex(perspective, kingSquare, piece, square);
+			}
+
+			while (!came.empty())
+			{
+				chess::Square square(came.pop());
+				added[addedCount++] = featureIndex(perspective, kingSquare, piece, square);
+			}
+		}
+	}
+
+	int index = static_cast<int>(perspective);
+	std::int16_t* values = acc.values[index];
+	std::copy(fromAcc.values[index], fromAcc.values[index] + NNUE_HALF_DIMENSIONS, values);
+	for (int i = 0; i < removedCount; i++)
+	{
+		subFeature(values, m_Network.featureWeights(removed[i]));
+	}
+
+	for (int i = 0; i < addedCount; i++)
+	{
+		addFeature(values, m_Network.featureWeights(added[i]));
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "chess.hpp"
+#include "leaf-evaluator.h"
+
+namespace ChessSimulator {
+	/*
+	* Small efficiently updatable network (NNUE) for valuing positions on the CPU.
+	*
+	* - Inputs are HalfKP-like features, one set per perspective: (own king square, piece, square)
+	*	for every non-king piece, with squares flipped vertically for black's perspective.
+	* - Each perspective's features feed an int16 accumulator of NNUE_HALF_DIMENSIONS values.
+	*	Accumulators are updated incrementally as moves are made and popped when they're unmade.
+	*	A king move changes every feature of its own perspective, so only that one is rebuilt.
+	* - The output is a clipped ReLU over both accumulators (side to move first) followed by a
+	*	single int16 linear layer, giving a score in centipawns for the side to move.
+	* - Kernels use AVX2 or SSE4.1 when the build targets them and plain loops otherwise.
+	*
+	* Weights file layout (little endian):
+	*	u32 magic 'NNUE', u32 version, u32 half dimensions
+	*	i16 featureBias[NNUE_HALF_DIMENSIONS]
+	*	i16 featureWeights[NNUE_FEATURES][NNUE_HALF_DIMENSIONS]
+	*	i32 outputBias
+	*	i16 outputWeights[2 * NNUE_HALF_DIMENSIONS]
+	*/
+	constexpr int NNUE_HALF_DIMENSIONS = 128;
+	constexpr int NNUE_FEATURES = 64 * 10 * 64;
+
+	struct NNUE_Accumulator
+	{
+		alignas(64) std::int16_t values[2][NNUE_HALF_DIMENSIONS];
+	};
+
+	class NNUE_Network
+	{
+	public:
+		// Load weights from a file, returns false if it's missing or doesn't match
+		bool load(const std::string& path);
+
+		// Fill the network with small random weights, for benchmarking without a trained file
+		void randomize(std::uint32_t seed);
+
+		bool isLoaded() const;
+		// Hash of the weights, telling networks apart in shared caches
+		std::uint64_t getFingerprint() const;
+
+	private:
+		friend class NNUE_Evaluator;
+		friend class NNUE_BatchEvaluator;
+
+		void updateFingerprint();
+		const std::int16_t* featureWeights(int feature) const;
+		// Rebuild one perspective of an accumulator from scratch
+		void buildPerspective(const chess::Board& board, NNUE_Accumulator& acc, chess::Color perspective) const;
+		// Output layer over an accumulator, in centipawns for the side to move
+		int output(const NNUE_Accumulator& acc, chess::Color sideToMove) const;
+
+		std::vector<std::int16_t> m_FeatureBias;
+		std::vector<std::int16_t> m_FeatureWeights;
+		std::int32_t m_OutputBias = 0;
+		std::vector<std::int16_t> m_OutputWeights;
+		std::uint64_t m_Fingerprint = 0;
+	};
+
+	class NNUE_Evaluator
+	{
+	public:
+		NNUE_Evaluator(const NNUE_Network& network);
+
+		// Rebuild the accumulators from scratch for a board
+		void refresh(const chess::Board& board);
+
+		// Make or unmake a move on the board, keeping the accumulators in step
+		void makeMove(chess::Board& board, chess::Move move);
+		void unmakeMove(chess::Board& board, chess::Move move);
+
+		// Score of the current position in centipawns for the side to move
+		int evaluate(const chess::Board& board) const;
+
+	private:
+		const NNUE_Network& m_Network;
+		std::vector<NNUE_Accumulator> m_Stack;
+		int m_Top = 0;
+	};
+
+	/*
+	* Batch leaf evaluation through an NNUE_Network, for batched search.
+	*
+	* - Batches hold runs of sibling leaves, which differ from each other in a few squares,
+	*	so each accumulator is updated from the previous board's by the features that changed.
+	*	A perspective is only rebuilt when its king moved or too much changed.
+	* - The output layer then runs over the whole batch in one pass.
+	*/
+	class NNUE_BatchEvaluator : public MCTS_LeafEvaluator
+	{
+	public:
+		NNUE_BatchEvaluator(const NNUE_Network& network);
+
+		void evaluateBatch(const chess::Board* boards, int count, float* values) override;
+
+	private:
+		bool updatePerspective(const chess::Board& from, const NNUE_Accumulator& fromAcc, const chess::Board& board,
+			NNUE_Accumulator& acc, chess::Color perspective) const;
+
+		const NNUE_Network& m_Network;
+		std::vector<NNUE_Accumulator> m_Accumulators;
+	};
+}
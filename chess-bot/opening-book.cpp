@@ -0,0 +1,160 @@
+#include "opening-book.h"
+
+using namespace ChessSimulator;
+
+namespace {
+	constexpr size_t kEntrySize = 16;
+
+	std::uint64_t readBigEndian(const unsigned char* data, int bytes)
+	{
+		std::uint64_t value = 0;
+		for (int i = 0; i < bytes; i++)
+		{
+			value = (value << 8) | data[i];
+		}
+		return value;
+	}
+}
+
+bool OpeningBook::open(const std::string& path)
+{
+	m_Entries = 0;
+	if (!m_File.open(path))
+	{
+		return false;
+	}
+
+	m_Entries = m_File.size() / kEntrySize;
+	return m_Entries != 0;
+}
+
+void OpeningBook::close()
+{
+	m_File.close();
+	m_Entries = 0;
+}
+
+bool OpeningBook::isOpen() const
+{
+	return m_Entries != 0;
+}
+
+chess::Move OpeningBook::probe(const chess::Board& board, std::mt19937& rng) const
+{
+	if (!isOpen())
+	{
+		return chess::Move(chess::Move::NO_MOVE);
+	}
+
+	// Find the first entry for the position
+	std::uint64_t key = board.hash();
+	size_t low = 0;
+	size_t high = m_Entries;
+	while (low < high)
+	{
+		size_t mid = low + (high - low) / 2;
+		if (entryKey(mid) < key)
+		{
+			low = mid + 1;
+		}
+
+		else
+		{
+			high = mid;
+		}
+	}
+
+	// Weighted pick among the position's legal book moves
+	chess::Move moves[64];
+	std::uint32_t weights[64];
+	int count = 0;
+	std::uint32_t totalWeight = 0;
+	for (size_t index = low; index < m_Entries && entryKey(index) == key && count < 64; index++)
+	{
+		chess::Move move = decodeMove(board, entryMove(index));
+		if (move == chess::Move(chess::Move::NO_MOVE))
+		{
+			continue;
+		}
+
+		moves[count] = move;
+		weights[count] = entryWeight(index);
+		totalWeight += weights[count];
+		count++;
+	}
+
+	if (count == 0)
+	{
+		return chess::Move(chess::Move::NO_MOVE);
+	}
+
+	// Books with all zero weights still count as in book
+	if (totalWeight == 0)
+	{
+		std::uniform_int_distribution<int> pick(0, count - 1);
+		return moves[pick(rng)];
+	}
+
+	std::uniform_int_distribution<std::uint32_t> pick(0, totalWeight - 1);
+	std::uint32_t target = pick(rng);
+	for (int i = 0; i < count; i++)
+	{
+		if (target < weights[i])
+		{
+			return moves[i];
+		}
+		target -= weights[i];
+	}
+
+	return moves[count - 1];
+}
+
+std::uint64_t OpeningBook::entryKey(size_t index) const
+{
+	return readBigEndian(m_File.data() + index * kEntrySize, 8);
+}
+
+std::uint16_t OpeningBook::entryMove(size_t index) const
+{
+	return static_cast<std::uint16_t>(readBigEndian(m_File.data() + index * kEntrySize + 8, 2));
+}
+
+std::uint16_t OpeningBook::entryWeight(size_t index) const
+{
+	return static_cast<std::uint16_t>(readBigEndian(m_File.data() + index * kEntrySize + 10, 2));
+}
+
+// Match a Polyglot move against the legal moves of the board. Polyglot
+// writes castling as the king taking its rook, like chess::Move does.
+chess::Move OpeningBook::decodeMove(const chess::Board& board, std::uint16_t bookMove) const
+{
+	int to = bookMove & 63;
+	int from = (bookMove >> 6) & 63;
+	int promotion = (bookMove >> 12) & 7;
+
+	static constexpr chess::PieceType::underlying promotionTypes[5] = {
+		chess::PieceType::NONE, chess::PieceType::KNIGHT, chess::PieceType::BISHOP, chess::PieceType::ROOK, chess::PieceType::QUEEN
+	};
+
+	chess::Movelist moves;
+	chess::movegen::legalmoves(moves, board);
+	for (auto const& move : moves)
+	{
+		if (move.from().index() != from || move.to().index() != to)
+		{
+			continue;
+		}
+
+		if (move.typeOf() == chess::Move::PROMOTION)
+		{
+			if (promotion == 0 || promotion > 4 || move.promotionType() != chess::PieceType(promotionTypes[promotion]))
+			{
+				continue;
+			}
+		}
+
+		return move;
+	}
+
+	return chess::Move(chess::Move::NO_MOVE);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include "chess.hpp"
+#include "mapped-file.h"
+
+namespace ChessSimulator {
+	/*
+	* Read-only Polyglot (.bin) opening book.
+	*
+	* - The file is memory-mapped where the platform allows it and read into memory otherwise,
+	*	so opening a book costs nothing in proportion to its size.
+	* - Entries are 16 byte big endian records (key, move, weight, learn) sorted by key, so
+	*	a position's entries are found with a binary search on its Zobrist key.
+	* - chess::Board::hash() uses the Polyglot Zobrist keys, so it's used as the key directly.
+	* - probe() picks one of the position's moves at random, weighted by the entries' weights.
+	*/
+	class OpeningBook
+	{
+	public:
+		bool open(const std::string& path);
+		void close();
+		bool isOpen() const;
+
+		// A weighted book move for the position, or NO_MOVE when it's out of book
+		chess::Move probe(const chess::Board& board, std::mt19937& rng) const;
+
+	private:
+		std::uint64_t entryKey(size_t index) const;
+		std::uint16_t entryMove(size_t index) const;
+		std::uint16_t entryWeight(size_t index) const;
+		chess::Move decodeMove(const chess::Board& board, std::uint16_t bookMove) const;
+
+		MappedFile m_File;
+		size_t m_Entries = 0;
+	};
+}
@@ -0,0 +1,90 @@
+#include "playout-policy.h"
+#include "move-heuristics.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace ChessSimulator;
+
+namespace {
+	chess::Move pickHeavy(chess::Board& board, const chess::Movelist& moves, float temperature, std::mt19937& rng)
+	{
+		float weights[256];
+		float bestScore = -1e9f;
+
+		for (int i = 0; i < moves.size(); i++)
+		{
+			const chess::Move move = moves[i];
+			int score = 0;
+
+			// SEE of a quiet move is the material it leaves hanging.
+			// It already counts what a promotion gains.
+			int exchange = see(board, move);
+			if (board.isCapture(move) && move.typeOf() != chess::Move::CASTLING)
+			{
+				chess::PieceType victim = move.typeOf() == chess::Move::ENPASSANT ? chess::PieceType::PAWN : board.at(move.to()).type();
+				int gainValue = pieceValue(victim);
+				if (move.typeOf() == chess::Move::PROMOTION)
+				{
+					gainValue += pieceValue(move.promotionType()) - pieceValue(chess::PieceType::PAWN);
+				}
+
+				// Undefended victims come for free
+				score += exchange >= gainValue ? gainValue : exchange;
+			}
+
+			else
+			{
+				score += exchange;
+			}
+
+			// Only checking moves can mate, so only they pay for a reply generation
+			board.makeMove(move);
+			if (board.inCheck())
+			{
+				chess::Movelist replies;
+				chess::movegen::legalmoves(replies, board);
+				if (replies.empty())
+				{
+					board.unmakeMove(move);
+					return move;
+				}
+			}
+			board.unmakeMove(move);
+
+			weights[i] = score / temperature;
+			bestScore = std::max(bestScore, weights[i]);
+		}
+
+		// Softmax sample, shifted by the best score to keep exp() in range
+		float total = 0;
+		for (int i = 0; i < moves.size(); i++)
+		{
+			weights[i] = std::exp(weights[i] - bestScore);
+			total += weights[i];
+		}
+
+		std::uniform_real_distribution<float> pick(0, total);
+		float target = pick(rng);
+		for (int i = 0; i < moves.size(); i++)
+		{
+			target -= weights[i];
+			if (target <= 0)
+			{
+				return moves[i];
+			}
+		}
+
+		return moves[moves.size() - 1];
+	}
+}
+
+chess::Move ChessSimulator::pickPlayoutMove(chess::Board& board, const chess::Movelist& moves, MCTS_Playout policy, float temperature, std::mt19937& rng)
+{
+	if (policy == MCTS_Playout::HEAVY)
+	{
+		return pickHeavy(board, moves, temperature, rng);
+	}
+
+	std::uniform_int_distribution<> moveRange(0, moves.size() - 1);
+	return moves[moveRange(rng)];
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <random>
+#include "chess.hpp"
+
+namespace ChessSimulator {
+	enum class MCTS_Playout
+	{
+		UNIFORM,	// Pick uniformly among legal moves. Fastest, but mostly noise.
+		HEAVY		// Take mates in one, prefer winning captures, avoid hanging pieces
+	};
+
+	/*
+	* Pick the next move of a playout.
+	*
+	* - UNIFORM draws a legal move at random.
+	* - HEAVY scores every legal move with cheap tactical filters and samples from a softmax
+	*	over the scores (temperature in centipawns). A mate in one is always played.
+	*		- Captures that win the whole victim (undefended pieces) get the victim's full value.
+	*		- Moves that lose material by SEE, such as hanging a piece, are penalised by the loss.
+	*		- Promotions get the gain of the promoted piece.
+	* - The board is left unchanged, moves are only tried and taken back.
+	*/
+	chess::Move pickPlayoutMove(chess::Board& board, const chess::Movelist& moves, MCTS_Playout policy, float temperature, std::mt19937& rng);
+}
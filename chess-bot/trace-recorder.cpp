@@ -0,0 +1,200 @@
+#include "trace-recorder.h"
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+
+using namespace ChessSimulator;
+
+namespace {
+	std::atomic<std::uint64_t> nextRecorderId = 1;
+
+	// Buffers this thread used lately, by the recorder they belong to. Older entries
+	// are replaced in turn, and the recorder finds this thread's buffer again for them.
+	constexpr int kCachedRecorders = 4;
+
+	struct ThreadBufferCache
+	{
+		std::uint64_t recorderIds[kCachedRecorders] = {};
+		MCTS_TraceBuffer* buffers[kCachedRecorders] = {};
+		int next = 0;
+	};
+	thread_local ThreadBufferCache threadCache;
+}
+
+MCTS_TraceBuffer::MCTS_TraceBuffer(int capacity, std::uint32_t threadId)
+	: m_Records(capacity), m_ThreadId(threadId)
+{
+}
+
+void MCTS_TraceBuffer::push(const MCTS_TraceRecord& record)
+{
+	std::uint64_t head = m_Head.load(std::memory_order_relaxed);
+	if (head - m_Tail.load(std::memory_order_acquire) >= m_Records.size())
+	{
+		m_Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	m_Records[head % m_Records.size()] = record;
+	m_Head.store(head + 1, std::memory_order_release);
+}
+
+int MCTS_TraceBuffer::drain(std::vector<MCTS_TraceRecord>& out)
+{
+	std::uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+	std::uint64_t head = m_Head.load(std::memory_order_acquire);
+	for (std::uint64_t i = tail; i < head; i++)
+	{
+		out.push_back(m_Records[i % m_Records.size()]);
+	}
+
+	m_Tail.store(head, std::memory_order_release);
+	return head - tail;
+}
+
+bool MCTS_TraceBuffer::hasPending() const
+{
+	return m_Head.load(std::memory_order_acquire) != m_Tail.load(std::memory_order_relaxed);
+}
+
+std::uint32_t MCTS_TraceBuffer::threadId() const
+{
+	return m_ThreadId;
+}
+
+std::uint64_t MCTS_TraceBuffer::dropped() const
+{
+	return m_Dropped.load(std::memory_order_relaxed);
+}
+
+MCTS_TraceRecorder::MCTS_TraceRecorder(const std::string& path, int bufferCapacity, int flushInterval)
+	: m_Path(path), m_BufferCapacity(bufferCapacity), m_Id(nextRecorderId++), m_FlushInterval(flushInterval)
+{
+	if (m_FlushInterval > 0)
+	{
+		m_Drainer = std::jthread([this](std::stop_token stop) { drainLoop(stop); });
+	}
+}
+
+MCTS_TraceRecorder::~MCTS_TraceRecorder()
+{
+	// Stop and join the drain thread, then write out what it left
+	m_Drainer = std::jthread();
+	flush();
+}
+
+// Flush every flushInterval milliseconds until stopped
+void MCTS_TraceRecorder::drainLoop(std::stop_token stop)
+{
+	std::mutex mutex;
+	std::condition_variable_any wake;
+	std::unique_lock lock(mutex);
+	while (!stop.stop_requested())
+	{
+		wake.wait_for(lock, stop, std::chrono::milliseconds(m_FlushInterval), [] { return false; });
+		if (!stop.stop_requested())
+		{
+			flush();
+		}
+	}
+}
+
+void MCTS_TraceRecorder::record(MCTS_TraceEvent type, std::uint32_t node, std::uint16_t arg, float result)
+{
+	MCTS_TraceRecord record;
+	record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	record.node = node;
+	record.arg = arg;
+	record.result = static_cast<std::int8_t>(std::lround(result * 100));
+	record.type = type;
+
+	threadBuffer().push(record);
+}
+
+MCTS_TraceBuffer& MCTS_TraceRecorder::threadBuffer()
+{
+	for (int i = 0; i < kCachedRecorders; i++)
+	{
+		if (threadCache.recorderIds[i] == m_Id)
+		{
+			return *threadCache.buffers[i];
+		}
+	}
+
+	// A thread that switched between recorders may have a buffer here already
+	MCTS_TraceBuffer* buffer = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		std::thread::id owner = std::this_thread::get_id();
+		for (int i = 0; i < m_Buffers.size(); i++)
+		{
+			if (m_BufferOwners[i] == owner)
+			{
+				buffer = m_Buffers[i].get();
+			}
+		}
+
+		if (!buffer)
+		{
+			m_Buffers.push_back(std::make_unique<MCTS_TraceBuffer>(m_BufferCapacity, m_Buffers.size()));
+			m_BufferOwners.push_back(owner);
+			buffer = m_Buffers.back().get();
+		}
+	}
+
+	int slot = threadCache.next;
+	threadCache.next = (slot + 1) % kCachedRecorders;
+	threadCache.recorderIds[slot] = m_Id;
+	threadCache.buffers[slot] = buffer;
+	return *buffer;
+}
+
+bool MCTS_TraceRecorder::flush()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Nothing new to write, the file only needs its header the first time
+	bool pending = false;
+	for (auto const& buffer : m_Buffers)
+	{
+		pending = pending || buffer->hasPending();
+	}
+
+	if (!pending && m_HeaderWritten)
+	{
+		return true;
+	}
+
+	std::ofstream file(m_Path, std::ios::binary | (m_HeaderWritten ? std::ios::app : std::ios::trunc));
+	if (!file)
+	{
+		return false;
+	}
+
+	if (!m_HeaderWritten)
+	{
+		std::uint32_t header[2] = { MCTS_TRACE_MAGIC, MCTS_TRACE_VERSION };
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+		m_HeaderWritten = true;
+	}
+
+	std::vector<MCTS_TraceRecord> records;
+	for (auto const& buffer : m_Buffers)
+	{
+		records.clear();
+		MCTS_TraceChunk chunk;
+		chunk.threadId = buffer->threadId();
+		chunk.count = buffer->drain(records);
+		chunk.dropped = buffer->dropped();
+		if (chunk.count == 0)
+		{
+			continue;
+		}
+
+		file.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+		file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(MCTS_TraceRecord));
+	}
+
+	return file.good();
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ChessSimulator {
+	enum class MCTS_TraceEvent : std::uint8_t
+	{
+		CYCLE_BEGIN,	// node: cycle number
+		SELECT,			// node: selected node, arg: its depth
+		EXPAND,			// node: expanded node, arg: children added
+		PLAYOUT,		// node: simulated node, arg: plies played, result: outcome
+		CYCLE_END		// node: cycle number
+	};
+
+	// One 16 byte trace event, written to trace files as-is
+	struct MCTS_TraceRecord
+	{
+		std::uint64_t time = 0;		// Nanoseconds on the steady clock
+		std::uint32_t node = 0;
+		std::uint16_t arg = 0;
+		std::int8_t result = 0;		// Playout result from the root's side, in hundredths
+		MCTS_TraceEvent type = MCTS_TraceEvent::CYCLE_BEGIN;
+	};
+	static_assert(sizeof(MCTS_TraceRecord) == 16, "trace records are written as-is");
+
+	/*
+	* Single producer, single consumer ring of trace records. The owning thread
+	* pushes without locking. When the ring is full new records are dropped and
+	* counted, so recording never blocks the search.
+	*/
+	class MCTS_TraceBuffer
+	{
+	public:
+		MCTS_TraceBuffer(int capacity, std::uint32_t threadId);
+
+		void push(const MCTS_TraceRecord& record);
+
+		// Move every pending record out, returns how many were taken
+		int drain(std::vector<MCTS_TraceRecord>& out);
+		bool hasPending() const;
+
+		std::uint32_t threadId() const;
+		std::uint64_t dropped() const;
+
+	private:
+		std::vector<MCTS_TraceRecord> m_Records;
+		std::uint32_t m_ThreadId = 0;
+		alignas(64) std::atomic<std::uint64_t> m_Head = 0;
+		alignas(64) std::atomic<std::uint64_t> m_Tail = 0;
+		std::atomic<std::uint64_t> m_Dropped = 0;
+	};
+
+	/*
+	* Low-overhead recorder of what a search does each cycle.
+	*
+	* - Every thread that records gets its own MCTS_TraceBuffer the first time it records,
+	*	so recording is a timestamp and a store into thread-local memory. Threads remember
+	*	their buffers in the last few recorders they used.
+	* - flush() appends the pending records of every thread to the trace file. A drain thread
+	*	flushes every flushInterval milliseconds so long searches don't overrun the rings,
+	*	and the search flushes what's left at the end of each genMove(). The file is only
+	*	opened when there's something to write.
+	* - File layout: u32 magic 'TRCE', u32 version, then chunks of
+	*	{u32 thread id, u32 record count, u64 records dropped so far, records}.
+	* - chess-trace decodes the files into summaries or a replay of the events.
+	*/
+	class MCTS_TraceRecorder
+	{
+	public:
+		MCTS_TraceRecorder(const std::string& path, int bufferCapacity = 1 << 16, int flushInterval = 10);
+		~MCTS_TraceRecorder();
+
+		void record(MCTS_TraceEvent type, std::uint32_t node, std::uint16_t arg = 0, float result = 0);
+		bool flush();
+
+	private:
+		MCTS_TraceBuffer& threadBuffer();
+		void drainLoop(std::stop_token stop);
+
+		std::string m_Path;
+		int m_BufferCapacity = 0;
+		std::uint64_t m_Id = 0;
+
+		std::mutex m_Mutex;
+		std::vector<std::unique_ptr<MCTS_TraceBuffer>> m_Buffers;
+		std::vector<std::thread::id> m_BufferOwners;
+		bool m_HeaderWritten = false;
+
+		// Started last and stopped first, so it only runs while the rest is alive
+		int m_FlushInterval = 0;
+		std::jthread m_Drainer;
+	};
+
+	// Trace file header and chunk layouts, shared with the decoder
+	constexpr std::uint32_t MCTS_TRACE_MAGIC = 0x45435254; // "TRCE"
+	constexpr std::uint32_t MCTS_TRACE_VERSION = 1;
+
+	struct MCTS_TraceChunk
+	{
+		std::uint32_t threadId = 0;
+		std::uint32_t count = 0;
+		std::uint64_t dropped = 0;
+	};
+}
@@ -0,0 +1,219 @@
+#include "training-data.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace ChessSimulator;
+
+namespace {
+	constexpr std::uint32_t kMagic = 0x534F5054; // "TPOS"
+	constexpr std::uint32_t kVersion = 1;
+
+	struct ShardHeader
+	{
+		std::uint32_t magic = kMagic;
+		std::uint32_t version = kVersion;
+	};
+	static_assert(sizeof(ShardHeader) == 8, "shard headers are written as-is");
+
+	constexpr const char* kPieceChars = "PNBRQKpnbrqk";
+}
+
+TrainingPosition ChessSimulator::packPosition(const chess::Board& board)
+{
+	TrainingPosition position;
+	position.occupancy = board.occ().getBits();
+
+	chess::Bitboard occupied = board.occ();
+	int count = 0;
+	while (occupied)
+	{
+		int square = occupied.pop();
+		int piece = static_cast<int>(board.at(chess::Square(square)).internal());
+		position.pieces[count / 2] |= piece << (count % 2 * 4);
+		count++;
+	}
+
+	using Side = chess::Board::CastlingRights::Side;
+	auto castling = board.castlingRights();
+	position.flags = board.sideToMove() == chess::Color::BLACK;
+	position.flags |= castling.has(chess::Color::WHITE, Side::KING_SIDE) << 1;
+	position.flags |= castling.has(chess::Color::WHITE, Side::QUEEN_SIDE) << 2;
+	position.flags |= castling.has(chess::Color::BLACK, Side::KING_SIDE) << 3;
+	position.flags |= castling.has(chess::Color::BLACK, Side::QUEEN_SIDE) << 4;
+
+	chess::Square ep = board.enpassantSq();
+	position.epFile = ep == chess::Square::NO_SQ ? 8 : static_cast<int>(ep.file());
+	position.halfMoves = std::min(board.halfMoveClock(), 255);
+
+	return position;
+}
+
+int ChessSimulator::unpackPieces(const TrainingPosition& position, int squares[32], int pieces[32])
+{
+	chess::Bitboard occupied(position.occupancy);
+	int count = 0;
+	while (occupied && count < 32)
+	{
+		squares[count] = occupied.pop();
+		pieces[count] = position.pieces[count / 2] >> (count % 2 * 4) & 0xF;
+		count++;
+	}
+
+	return count;
+}
+
+chess::Board ChessSimulator::unpackBoard(const TrainingPosition& position)
+{
+	int squares[32];
+	int pieces[32];
+	int count = unpackPieces(position, squares, pieces);
+
+	char board[64];
+	std::fill(board, board + 64, ' ');
+	for (int i = 0; i < count; i++)
+	{
+		board[squares[i]] = kPieceChars[pieces[i] % 12];
+	}
+
+	// Rebuild the FEN rank by rank from the eighth
+	std::string fen;
+	for (int rank = 7; rank >= 0; rank--)
+	{
+		int empty = 0;
+		for (int file = 0; file < 8; file++)
+		{
+			char piece = board[rank * 8 + file];
+			if (piece == ' ')
+			{
+				empty++;
+				continue;
+			}
+
+			if (empty > 0)
+			{
+				fen += std::to_string(empty);
+				empty = 0;
+			}
+			fen += piece;
+		}
+
+		if (empty > 0)
+		{
+			fen += std::to_string(empty);
+		}
+		fen += rank > 0 ? "/" : "";
+	}
+
+	bool blackToMove = position.flags & 1;
+	fen += blackToMove ? " b " : " w ";
+
+	std::string castling;
+	castling += position.flags & 2 ? "K" : "";
+	castling += position.flags & 4 ? "Q" : "";
+	castling += position.flags & 8 ? "k" : "";
+	castling += position.flags & 16 ? "q" : "";
+	fen += castling.empty() ? "-" : castling;
+
+	if (position.epFile < 8)
+	{
+		fen += " ";
+		fen += static_cast<char>('a' + position.epFile);
+		fen += blackToMove ? "3" : "6";
+	}
+
+	else
+	{
+		fen += " -";
+	}
+
+	fen += " " + std::to_string(position.halfMoves) + " 1";
+	return chess::Board(fen);
+}
+
+TrainingDataWriter::TrainingDataWriter(const std::string& prefix, std::int64_t positionsPerShard)
+{
+	m_Prefix = prefix;
+	m_PositionsPerShard = positionsPerShard;
+}
+
+bool TrainingDataWriter::openShard()
+{
+	char suffix[16];
+	std::snprintf(suffix, sizeof(suffix), "-%04d.bin", m_Shards);
+
+	m_File.close();
+	m_File.open(m_Prefix + suffix, std::ios::binary);
+	if (!m_File)
+	{
+		return false;
+	}
+
+	ShardHeader header;
+	m_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_Shards++;
+	m_ShardPositions = 0;
+	return m_File.good();
+}
+
+bool TrainingDataWriter::write(const std::vector<TrainingRecord>& game)
+{
+	thread_local std::vector<char> buffer;
+	buffer.clear();
+	for (auto const& record : game)
+	{
+		TrainingPosition position = record.position;
+		position.visitCount = record.visits.size();
+
+		const char* positionBytes = reinterpret_cast<const char*>(&position);
+		const char* visitBytes = reinterpret_cast<const char*>(record.visits.data());
+		buffer.insert(buffer.end(), positionBytes, positionBytes + sizeof(position));
+		buffer.insert(buffer.end(), visitBytes, visitBytes + record.visits.size() * sizeof(TrainingVisit));
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_File.is_open() || m_ShardPositions >= m_PositionsPerShard)
+	{
+		if (!openShard())
+		{
+			return false;
+		}
+	}
+
+	m_File.write(buffer.data(), buffer.size());
+	m_File.flush();
+	m_ShardPositions += game.size();
+	m_Positions += game.size();
+	return m_File.good();
+}
+
+std::int64_t TrainingDataWriter::getPositions() const
+{
+	return m_Positions;
+}
+
+int TrainingDataWriter::getShards() const
+{
+	return m_Shards;
+}
+
+bool TrainingDataReader::open(const std::string& path)
+{
+	m_File.close();
+	m_File.open(path, std::ios::binary);
+
+	ShardHeader header;
+	m_File.read(reinterpret_cast<char*>(&header), sizeof(header));
+	return m_File && header.magic == kMagic && header.version == kVersion;
+}
+
+bool TrainingDataReader::next(TrainingRecord& record)
+{
+	if (!m_File.read(reinterpret_cast<char*>(&record.position), sizeof(TrainingPosition)))
+	{
+		return false;
+	}
+
+	record.visits.resize(record.position.visitCount);
+	m_File.read(reinterpret_cast<char*>(record.visits.data()), record.visits.size() * sizeof(TrainingVisit));
+	return static_cast<bool>(m_File);
+}
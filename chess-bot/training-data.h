@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "chess.hpp"
+
+namespace ChessSimulator {
+	/*
+	* Position record of the self-play training data format.
+	*
+	* - Pieces are packed as an occupancy bitboard followed by one nibble per
+	*	occupied square in square order (chess::Piece values, 0-11), so any
+	*	legal position fits in 24 bytes.
+	* - Flags hold the side to move (bit 0) and castling rights (bits 1-4: white
+	*	king side, white queen side, black king side, black queen side).
+	* - Value and result are from the side to move's point of view. The value is
+	*	the search value scaled to [-32767, 32767], the result is 1, 0 or -1.
+	* - visitCount root move visits (TrainingVisit) follow each record.
+	*/
+	struct TrainingPosition
+	{
+		std::uint64_t occupancy = 0;
+		std::uint8_t pieces[16] = {};
+		std::uint8_t flags = 0;
+		std::uint8_t epFile = 8;	// 8 when there's no en passant square
+		std::uint8_t halfMoves = 0;
+		std::int8_t result = 0;
+		std::int16_t value = 0;
+		std::uint16_t visitCount = 0;
+	};
+	static_assert(sizeof(TrainingPosition) == 32, "training positions are written as-is");
+
+	struct TrainingVisit
+	{
+		std::uint16_t move = 0;
+		std::uint16_t visits = 0;
+	};
+	static_assert(sizeof(TrainingVisit) == 4, "training visits are written as-is");
+
+	struct TrainingRecord
+	{
+		TrainingPosition position;
+		std::vector<TrainingVisit> visits;
+	};
+
+	// Pack a board's position, leaving the value, result and visits empty
+	TrainingPosition packPosition(const chess::Board& board);
+
+	// Squares and pieces (chess::Piece values) of a packed position. Returns the piece count.
+	int unpackPieces(const TrainingPosition& position, int squares[32], int pieces[32]);
+
+	chess::Board unpackBoard(const TrainingPosition& position);
+
+	/*
+	* Streams self-play games into sharded training data files.
+	*
+	* - Shards are named <prefix>-0000.bin, <prefix>-0001.bin, ... and start with an
+	*	8 byte header (u32 magic 'TPOS', u32 version) followed by records until the end of the file.
+	* - A shard is closed once it holds positionsPerShard positions. Games are never
+	*	split across shards, so every shard can be used on its own.
+	* - write() is safe to call from several threads. Games are serialised before
+	*	taking the lock, which is only held to append them to the shard.
+	*/
+	class TrainingDataWriter
+	{
+	public:
+		TrainingDataWriter(const std::string& prefix, std::int64_t positionsPerShard);
+
+		// Append a finished game's positions
+		bool write(const std::vector<TrainingRecord>& game);
+
+		std::int64_t getPositions() const;
+		int getShards() const;
+
+	private:
+		bool openShard();
+
+		std::string m_Prefix;
+		std::int64_t m_PositionsPerShard = 0;
+
+		std::mutex m_Mutex;
+		std::ofstream m_File;
+		int m_Shards = 0;
+		std::int64_t m_ShardPositions = 0;
+		std::atomic<std::int64_t> m_Positions = 0;
+	};
+
+	// Reads the records of one training data shard in order
+	class TrainingDataReader
+	{
+	public:
+		bool open(const std::string& path);
+		bool next(TrainingRecord& record);
+
+	private:
+		std::ifstream m_File;
+	};
+}
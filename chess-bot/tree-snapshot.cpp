@@ -0,0 +1,91 @@
+#include "tree-snapshot.h"
+#include <cstring>
+#include <fstream>
+
+using namespace ChessSimulator;
+
+namespace {
+	constexpr std::uint32_t kMagic = 0x5354434D; // "MCTS"
+	constexpr std::uint32_t kVersion = 1;
+
+	struct SnapshotHeader
+	{
+		std::uint32_t magic = kMagic;
+		std::uint32_t version = kVersion;
+		std::uint32_t nodeCount = 0;
+		std::uint32_t reserved = 0;
+		std::uint64_t rootHash = 0;
+		std::uint64_t reserved2 = 0;
+	};
+	static_assert(sizeof(SnapshotHeader) == 32, "snapshot headers are written as-is");
+}
+
+bool MCTS_TreeSnapshot::write(const std::string& path, std::uint64_t rootHash, const std::vector<MCTS_SnapshotNode>& nodes)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	SnapshotHeader header;
+	header.nodeCount = nodes.size();
+	header.rootHash = rootHash;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(MCTS_SnapshotNode));
+
+	return file.good();
+}
+
+bool MCTS_TreeSnapshot::open(const std::string& path)
+{
+	close();
+	if (!m_File.open(path) || m_File.size() < sizeof(SnapshotHeader))
+	{
+		close();
+		return false;
+	}
+
+	SnapshotHeader header;
+	std::memcpy(&header, m_File.data(), sizeof(header));
+	size_t expectedSize = sizeof(SnapshotHeader) + static_cast<size_t>(header.nodeCount) * sizeof(MCTS_SnapshotNode);
+	if (header.magic != kMagic || header.version != kVersion || m_File.size() < expectedSize)
+	{
+		close();
+		return false;
+	}
+
+	// The header keeps the nodes 8 byte aligned within the mapping
+	m_Nodes = reinterpret_cast<const MCTS_SnapshotNode*>(m_File.data() + sizeof(SnapshotHeader));
+	m_NodeCount = header.nodeCount;
+	m_RootHash = header.rootHash;
+	return true;
+}
+
+void MCTS_TreeSnapshot::close()
+{
+	m_File.close();
+	m_Nodes = nullptr;
+	m_NodeCount = 0;
+	m_RootHash = 0;
+}
+
+bool MCTS_TreeSnapshot::isOpen() const
+{
+	return m_Nodes != nullptr;
+}
+
+std::uint64_t MCTS_TreeSnapshot::rootHash() const
+{
+	return m_RootHash;
+}
+
+int MCTS_TreeSnapshot::nodeCount() const
+{
+	return m_NodeCount;
+}
+
+const MCTS_SnapshotNode* MCTS_TreeSnapshot::nodes() const
+{
+	return m_Nodes;
+}
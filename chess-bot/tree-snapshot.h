@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped-file.h"
+
+namespace ChessSimulator {
+	/*
+	* Node record of a search tree snapshot.
+	*
+	* Nodes are stored breadth first so every node's children sit next to each
+	* other, which lets a node refer to them with a first index and a count.
+	*/
+	struct MCTS_SnapshotNode
+	{
+		std::uint32_t firstChild = 0;
+		std::uint16_t childCount = 0;
+		std::uint16_t move = 0;
+		std::int32_t visits = 0;
+		float simReward = 0;
+		float prior = 0;
+		std::uint8_t proof = 0;
+		std::uint8_t reserved[3] = {};
+	};
+	static_assert(sizeof(MCTS_SnapshotNode) == 24, "snapshot nodes are written as-is");
+
+	/*
+	* Compact binary snapshot of an MCTS search tree.
+	*
+	* - Layout (little endian): a 32 byte header (u32 magic 'MCTS', u32 version, u32 node count,
+	*	u32 reserved, u64 Zobrist key of the root position, u64 reserved) followed by the nodes.
+	* - open() memory-maps the file and exposes the nodes in place without parsing them,
+	*	so large trees can be inspected or used to warm start a search instantly.
+	* - The root key lets a search check a snapshot belongs to its position before using it.
+	*/
+	class MCTS_TreeSnapshot
+	{
+	public:
+		static bool write(const std::string& path, std::uint64_t rootHash, const std::vector<MCTS_SnapshotNode>& nodes);
+
+		bool open(const std::string& path);
+		void close();
+		bool isOpen() const;
+
+		std::uint64_t rootHash() const;
+		int nodeCount() const;
+		const MCTS_SnapshotNode* nodes() const;
+
+	private:
+		MappedFile m_File;
+		const MCTS_SnapshotNode* m_Nodes = nullptr;
+		int m_NodeCount = 0;
+		std::uint64_t m_RootHash = 0;
+	};
+}
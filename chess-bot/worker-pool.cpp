@@ -0,0 +1,85 @@
+#include "worker-pool.h"
+
+using namespace ChessSimulator;
+
+MCTS_WorkerPool::MCTS_WorkerPool(int workers)
+{
+	for (int i = 1; i < workers; i++)
+	{
+		m_Threads.emplace_back(&MCTS_WorkerPool::workerLoop, this, i);
+	}
+}
+
+MCTS_WorkerPool::~MCTS_WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_WakeCv.notify_all();
+
+	for (auto& thread : m_Threads)
+	{
+		thread.join();
+	}
+}
+
+int MCTS_WorkerPool::size() const
+{
+	return m_Threads.size() + 1;
+}
+
+void MCTS_WorkerPool::run(int count, const std::function<void(int task, int worker)>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Task = &task;
+		m_Count = count;
+		m_Next = 0;
+		m_Active = m_Threads.size();
+		m_Generation++;
+	}
+	m_WakeCv.notify_all();
+
+	// The caller works as worker 0 rather than sitting idle
+	drain(0);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_DoneCv.wait(lock, [this] { return m_Active == 0; });
+	m_Task = nullptr;
+}
+
+void MCTS_WorkerPool::workerLoop(int worker)
+{
+	std::uint64_t seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WakeCv.wait(lock, [&] { return m_Stop || m_Generation != seenGeneration; });
+			if (m_Stop)
+			{
+				return;
+			}
+			seenGeneration = m_Generation;
+		}
+
+		drain(worker);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Active--;
+		if (m_Active == 0)
+		{
+			m_DoneCv.notify_one();
+		}
+	}
+}
+
+// Take tasks until there are none left
+void MCTS_WorkerPool::drain(int worker)
+{
+	for (int index = m_Next++; index < m_Count; index = m_Next++)
+	{
+		(*m_Task)(index, worker);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ChessSimulator {
+	/*
+	* Fixed set of threads that run batches of independent tasks.
+	*
+	* run() hands out task indices to the pool threads and the calling thread alike, and
+	* returns once every task is done. Tasks are told which worker runs them (0 is the
+	* caller), so they can use per-worker scratch state such as random generators.
+	*/
+	class MCTS_WorkerPool
+	{
+	public:
+		// Workers in total, including the thread calling run()
+		MCTS_WorkerPool(int workers);
+		~MCTS_WorkerPool();
+
+		int size() const;
+
+		void run(int count, const std::function<void(int task, int worker)>& task);
+
+	private:
+		void workerLoop(int worker);
+		void drain(int worker);
+
+		std::vector<std::thread> m_Threads;
+		std::mutex m_Mutex;
+		std::condition_variable m_WakeCv;
+		std::condition_variable m_DoneCv;
+
+		const std::function<void(int, int)>* m_Task = nullptr;
+		int m_Count = 0;
+		std::atomic<int> m_Next = 0;
+		int m_Active = 0;
+		std::uint64_t m_Generation = 0;
+		bool m_Stop = false;
+	};
+}
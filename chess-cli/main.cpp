@@ -1,10 +1,261 @@
 #include "chess-simulator.h"
 #include "chess.hpp"
+#include "mcts-ensemble.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stop_token>
 #include <string>
+#include <thread>
+#include <vector>
+
+// Print analysis lines the way UCI engines do, scores in centipawns for the side to move
+static void printInfo(const std::vector<ChessSimulator::MCTS_PVLine> &lines) {
+    for (int i = 0; i < lines.size(); i++) {
+        auto const &line = lines[i];
+
+        int score;
+        if (line.proof == ChessSimulator::MCTS_Proof::ROOT_WIN) {
+            score = 10000;
+        } else if (line.proof == ChessSimulator::MCTS_Proof::ROOT_LOSS) {
+            score = -10000;
+        } else if (line.proof == ChessSimulator::MCTS_Proof::DRAW) {
+            score = 0;
+        } else {
+            float value = std::clamp(line.value, -0.999f, 0.999f);
+            score = std::lround(400.0 * std::log10((1 + value) / (1 - value)));
+        }
+
+        std::cout << "info multipv " << i + 1 << " depth " << line.pv.size() << " nodes " << line.visits
+                  << " score cp " << score << " pv";
+        for (auto const &move : line.pv) {
+            std::cout << " " << chess::uci::moveToUci(move);
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Print the progress of a running search as a UCI info line
+static void printProgress(const ChessSimulator::MCTS_Progress &progress) {
+    std::cout << "info time " << progress.milliseconds << " nodes " << progress.visits << " nps "
+              << std::lround(progress.playoutsPerSecond) << " pv " << chess::uci::moveToUci(progress.bestMove)
+              << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    int multiPV = 0;
+    int cycles = 10;
+    bool cyclesGiven = false;
+    int moveTime = 0;
+    int processes = 0;
+    std::string loadTree;
+    std::string saveTree;
+    ChessSimulator::EvalWeights evalWeights;
+    bool weightsGiven = false;
+    ChessSimulator::NNUE_Network network;
+    std::unique_ptr<ChessSimulator::NNUE_BatchEvaluator> batchEvaluator;
+    std::unique_ptr<ChessSimulator::MCTS_TraceRecorder> trace;
+    int batchSize = 0;
+    ChessSimulator::MCTS_Settings settings;
+    bool settingsGiven = false;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--book") {
+            std::string path = argv[++i];
+            if (!ChessSimulator::LoadOpeningBook(path)) {
+                std::cerr << "couldn't load opening book " << path << std::endl;
+                return 1;
+            }
+        } else if (std::string(argv[i]) == "--bitbases") {
+            std::string path = argv[++i];
+            if (!ChessSimulator::InitEndgameBitbases(path)) {
+                std::cerr << "couldn't load or save endgame bitbases " << path << std::endl;
+                return 1;
+            }
+        } else if (std::string(argv[i]) == "--multipv") {
+            multiPV = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--cycles") {
+            cycles = std::stoi(argv[++i]);
+            cyclesGiven = true;
+        } else if (std::string(argv[i]) == "--processes") {
+            processes = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--movetime") {
+            moveTime = std::stoi(argv[++i]);
+        } else if (std::string(argv[i]) == "--load-tree") {
+            loadTree = argv[++i];
+        } else if (std::string(argv[i]) == "--save-tree") {
+            saveTree = argv[++i];
+        } else if (std::string(argv[i]) == "--weights") {
+            std::string path = argv[++i];
+            if (!evalWeights.load(path)) {
+                std::cerr << "couldn't load weights " << path << std::endl;
+                return 1;
+            }
+            weightsGiven = true;
+        } else if (std::string(argv[i]) == "--hash") {
+            ChessSimulator::InitEvalCache(std::stoul(argv[++i]));
+        } else if (std::string(argv[i]) == "--selection") {
+            std::string selection = argv[++i];
+            if (selection == "uct") {
+                settings.selection = ChessSimulator::MCTS_Selection::UCT;
+            } else if (selection == "puct") {
+                settings.selection = ChessSimulator::MCTS_Selection::PUCT;
+            } else {
+                std::cerr << "unknown selection " << selection << ", expected uct or puct" << std::endl;
+                return 1;
+            }
+            settingsGiven = true;
+        } else if (std::string(argv[i]) == "--puct-c") {
+            settings.puctC = std::stof(argv[++i]);
+            settingsGiven = true;
+        } else if (std::string(argv[i]) == "--nnue") {
+            // Value leaves with a trained network instead of playing them out
+            std::string path = argv[++i];
+            if (!network.load(path)) {
+                std::cerr << "couldn't load network " << path << std::endl;
+                return 1;
+            }
+            settings.leafEval = ChessSimulator::MCTS_LeafEval::NNUE;
+            settings.network = &network;
+            settingsGiven = true;
+        } else if (std::string(argv[i]) == "--batch") {
+            // Queue --nnue leaves and value them this many at a time
+            batchSize = std::stoi(argv[++i]);
+            settingsGiven = true;
+        } else if (std::string(argv[i]) == "--trace") {
+            // Record what the search does each cycle, for chesstrace to decode
+            trace = std::make_unique<ChessSimulator::MCTS_TraceRecorder>(argv[++i]);
+            settings.trace = trace.get();
+            settingsGiven = true;
+        } else if (std::string(argv[i]) == "--rave") {
+            // Samples at which a node's own value and its RAVE value weigh the same
+            settings.rave = true;
+            settings.raveEquivalence = std::stof(argv[++i]);
+            settingsGiven = true;
+        }
+    }
 
-int main() {
     std::string fen;
     getline(std::cin, fen);
-    auto move = ChessSimulator::Move(fen);
-    std::cout << move << std::endl;
-}
\ No newline at end of file
+
+    // Both value leaves, with different evaluations
+    if (weightsGiven && settings.network) {
+        std::cerr << "--weights and --nnue can't be combined" << std::endl;
+        return 1;
+    }
+
+    if (batchSize > 0) {
+        if (!settings.network) {
+            std::cerr << "--batch needs a network from --nnue" << std::endl;
+            return 1;
+        }
+        batchEvaluator = std::make_unique<ChessSimulator::NNUE_BatchEvaluator>(network);
+        settings.leafEval = ChessSimulator::MCTS_LeafEval::BATCH;
+        settings.batchEvaluator = batchEvaluator.get();
+        settings.batchSize = batchSize;
+    }
+
+    // Ensemble workers only report their root statistics when they finish
+    if (processes > 0 && (multiPV > 0 || moveTime > 0 || trace || !loadTree.empty() || !saveTree.empty())) {
+        std::cerr << "--processes can't be combined with --multipv, --movetime, --trace, --load-tree or --save-tree"
+                  << std::endl;
+        return 1;
+    }
+
+    // Move() searches with its own fixed budget, anything else needs its own settings
+    if (processes <= 0 && multiPV <= 0 && moveTime <= 0 && !cyclesGiven && !weightsGiven && !settingsGiven &&
+        loadTree.empty() && saveTree.empty()) {
+        auto move = ChessSimulator::Move(fen);
+        std::cout << move << std::endl;
+        return 0;
+    }
+
+    // A move time without a cycle budget searches until the time runs out
+    if (moveTime > 0 && !cyclesGiven) {
+        cycles = -1;
+    }
+
+    // Analysis streams the top lines while it searches, timed searches report their progress
+    if (multiPV > 0) {
+        settings.multiPV = multiPV;
+        settings.analysisInterval = cycles > 0 ? std::max(1, cycles / 10) : 100;
+        settings.analysis = printInfo;
+    }
+    if (moveTime > 0) {
+        settings.progress = printProgress;
+    }
+
+    // Tuned weights (chesstune output) value leaves with the static evaluation
+    if (weightsGiven) {
+        settings.leafEval = ChessSimulator::MCTS_LeafEval::STATIC;
+        settings.evalWeights = &evalWeights;
+    }
+
+    // Long analysis runs independent searches in separate processes and merges their root statistics
+    if (processes > 0) {
+        ChessSimulator::MCTS_Ensemble ensemble(chess::Board(fen), cycles, processes, std::random_device()(), settings);
+        auto move = ensemble.genMove();
+        for (auto const &stat : ensemble.getMergedStats()) {
+            std::cout << "info string move " << chess::uci::moveToUci(chess::Move(stat.move)) << " visits "
+                      << stat.visits << " reward " << stat.simReward << std::endl;
+        }
+        std::cout << "bestmove " << chess::uci::moveToUci(move) << std::endl;
+        return 0;
+    }
+
+    ChessSimulator::Session session(chess::Board(fen), cycles, settings);
+
+    // A tree saved by an earlier search of the same position gives this one a head start
+    if (!loadTree.empty()) {
+        ChessSimulator::MCTS_TreeSnapshot snapshot;
+        if (!snapshot.open(loadTree)) {
+            std::cerr << "couldn't open search tree " << loadTree << std::endl;
+            return 1;
+        }
+
+        if (session.getEvaluator().loadSnapshot(snapshot)) {
+            std::cout << "info string warm start from " << snapshot.nodeCount() << " nodes" << std::endl;
+        } else {
+            std::cout << "info string search tree " << loadTree << " is for another position or damaged" << std::endl;
+        }
+    }
+
+    // The timer stops the search once the move time is up, or
+    // is cancelled and joined as soon as the search ends first
+    std::stop_source stop;
+    std::jthread timer;
+    if (moveTime > 0) {
+        timer = std::jthread([&stop, moveTime](std::stop_token cancel) {
+            std::mutex mutex;
+            std::condition_variable_any wake;
+            std::unique_lock lock(mutex);
+            wake.wait_for(lock, cancel, std::chrono::milliseconds(moveTime), [] { return false; });
+            stop.request_stop();
+        });
+    }
+
+    // Analysis and tree saving search even when the book knows the position
+    bool search = multiPV > 0 || !saveTree.empty();
+    auto move = search ? session.getEvaluator().genMove(stop.get_token()) : session.genMove(stop.get_token());
+    timer = std::jthread();
+    if (session.getEvaluator().isTreeFull()) {
+        std::cout << "info string search tree is full, later cycles revisited leaves" << std::endl;
+    }
+    auto const &evalCache = ChessSimulator::GetEvalCache();
+    auto const &pawnCache = ChessSimulator::GetPawnCache();
+    if (evalCache.isReady()) {
+        std::cout << "info string eval cache " << evalCache.getProbes() << " probes " << evalCache.getHitRate() * 100
+                  << "% hits, pawn cache " << pawnCache.getProbes() << " probes " << pawnCache.getHitRate() * 100
+                  << "% hits" << std::endl;
+    }
+
+    if (!saveTree.empty() && !session.getEvaluator().saveSnapshot(saveTree)) {
+        std::cerr << "couldn't save search tree " << saveTree << std::endl;
+        return 1;
+    }
+    std::cout << "bestmove " << chess::uci::moveToUci(move) << std::endl;
+}
@@ -40,8 +40,12 @@ std::chrono::nanoseconds timeSpentLastMove = std::chrono::milliseconds::zero();
 string gameResult;
 vector<string> moves;
 
+// follows the game so each search reuses the tree of the last one
+ChessSimulator::Session session;
+
 void reset(chess::Board &board) {
   board = chess::Board();
+  session.setPosition(board);
   simulationState = SimulationState::PAUSED;
   timeSpentOnMoves = std::chrono::nanoseconds::zero();
   timeSpentLastMove = std::chrono::milliseconds::zero();
@@ -70,12 +74,13 @@ void move(chess::Board &board) {
   auto beforeTime = std::chrono::high_resolution_clock::now();
 
   // run!
-  auto moveStr = ChessSimulator::Move(board.getFen(true));
+  auto move = session.genMove();
   // get stats
   auto afterTime = std::chrono::high_resolution_clock::now();
   // apply move
-  auto move = chess::uci::uciToMove(board, moveStr);
+  session.makeMove(move);
   board.makeMove(move);
+  auto moveStr = chess::uci::moveToUci(move);
 
   // update stats
   timeSpentOnMoves += afterTime - beforeTime;
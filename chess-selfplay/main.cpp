@@ -0,0 +1,175 @@
+#include "chess-simulator.h"
+#include "training-data.h"
+#include "chess.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Games longer than this are scored as draws
+static constexpr int maxPlies = 400;
+// Opening plies picked in proportion to visits rather than played best, so games differ
+static constexpr int samplePlies = 8;
+
+struct SelfPlayJob {
+    ChessSimulator::TrainingDataWriter *writer;
+    std::atomic<int> nextGame = 0;
+    std::atomic<int> finished = 0;
+    std::atomic<long long> truncated = 0;
+    int games = 0;
+    int cycles = 0;
+    // Tuned static evaluation to value leaves with, playouts when missing
+    const ChessSimulator::EvalWeights *evalWeights = nullptr;
+};
+
+// Play games until the job runs out, keeping the tree between moves
+static void playGames(SelfPlayJob &job, std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    // Room for every cycle to expand 64 moves, twice over as advanceRoot() keeps up to half the tree
+    ChessSimulator::MCTS_Settings settings;
+    settings.treeSize = std::max(ChessSimulator::MCTS_TREE_SIZE, 2 * 64 * (job.cycles + 1));
+    if (job.evalWeights) {
+        settings.leafEval = ChessSimulator::MCTS_LeafEval::STATIC;
+        settings.evalWeights = job.evalWeights;
+    }
+    auto evaluator = std::make_unique<ChessSimulator::MCTS_Evaluator>(chess::Board(), job.cycles, rng(), settings);
+
+    std::vector<ChessSimulator::TrainingRecord> records;
+    while (job.nextGame++ < job.games) {
+        chess::Board board;
+        evaluator->setRoot(board);
+        records.clear();
+
+        auto gameOver = board.isGameOver();
+        int ply = 0;
+        while (gameOver.first == chess::GameResultReason::NONE && ply < maxPlies) {
+            chess::Move best = evaluator->genMove();
+            auto stats = evaluator->getRootStats();
+
+            // A search that ran out of nodes spent its later cycles revisiting leaves
+            // instead of growing the tree, so its visits aren't a comparable target
+            bool full = evaluator->isTreeFull();
+            if (full) {
+                job.truncated++;
+            }
+
+            ChessSimulator::TrainingRecord record;
+            record.position = ChessSimulator::packPosition(board);
+
+            chess::Move played = best;
+            int totalVisits = 0;
+            for (auto const &stat : stats) {
+                totalVisits += stat.visits + 1;
+                record.visits.push_back({stat.move, static_cast<std::uint16_t>(std::min(stat.visits + 1, 65535))});
+                if (stat.move == best.move()) {
+                    float value = std::clamp(stat.simReward / (stat.visits + 1), -1.0f, 1.0f);
+                    record.position.value = static_cast<std::int16_t>(value * 32767);
+                }
+            }
+
+            if (ply < samplePlies && totalVisits > 0) {
+                int pick = std::uniform_int_distribution<int>(0, totalVisits - 1)(rng);
+                for (auto const &stat : stats) {
+                    pick -= stat.visits + 1;
+                    if (pick < 0) {
+                        played = chess::Move(stat.move);
+                        break;
+                    }
+                }
+            }
+
+            if (!full) {
+                records.push_back(record);
+            }
+            board.makeMove(played);
+            evaluator->advanceRoot(played);
+            gameOver = board.isGameOver();
+            ply++;
+        }
+
+        // The result is for the side to move at the end, flip it for the other side's positions
+        int result = gameOver.second == chess::GameResult::WIN ? 1 : gameOver.second == chess::GameResult::LOSE ? -1 : 0;
+        bool blackLast = board.sideToMove() == chess::Color::BLACK;
+        for (auto &record : records) {
+            bool blackToMove = record.position.flags & 1;
+            record.position.result = blackToMove == blackLast ? result : -result;
+        }
+
+        job.writer->write(records);
+    }
+
+    job.finished++;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> args;
+    std::string weightsPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--weights" && i + 1 < argc) {
+            weightsPath = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
+    if (args.empty()) {
+        std::printf("usage: chessselfplay <output prefix> [games] [threads] [cycles] [positions per shard] "
+                    "[--weights weights.bin]\n");
+        return 1;
+    }
+
+    std::string prefix = args[0];
+    int games = args.size() > 1 ? std::stoi(args[1]) : 100;
+    int threads = args.size() > 2 ? std::stoi(args[2]) : std::max(1u, std::thread::hardware_concurrency());
+    int cycles = args.size() > 3 ? std::stoi(args[3]) : 200;
+    long long shardSize = args.size() > 4 ? std::stoll(args[4]) : 1000000;
+
+    ChessSimulator::EvalWeights evalWeights;
+    if (!weightsPath.empty() && !evalWeights.load(weightsPath)) {
+        std::printf("couldn't load weights %s\n", weightsPath.c_str());
+        return 1;
+    }
+
+    ChessSimulator::TrainingDataWriter writer(prefix, shardSize);
+    SelfPlayJob job;
+    job.writer = &writer;
+    job.games = games;
+    job.cycles = cycles;
+    job.evalWeights = weightsPath.empty() ? nullptr : &evalWeights;
+
+    std::printf("selfplay: %d games on %d threads, %d cycles per move\n", games, threads, cycles);
+
+    auto beforeTime = std::chrono::high_resolution_clock::now();
+    std::random_device seeder;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(playGames, std::ref(job), seeder());
+    }
+
+    // Report throughput while the workers play
+    while (job.finished < threads) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        double seconds =
+            std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - beforeTime).count();
+        long long positions = writer.getPositions();
+        std::printf("%8lld positions, %d games, %.1f positions/sec\n", positions, std::min(job.nextGame.load(), games),
+                    positions / seconds);
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - beforeTime).count();
+    std::printf("done: %lld positions in %d shards, %.2fs, %.1f positions/sec\n", (long long)writer.getPositions(),
+                writer.getShards(), seconds, writer.getPositions() / seconds);
+    if (job.truncated > 0) {
+        std::printf("skipped %lld positions whose search filled the tree\n", job.truncated.load());
+    }
+    return 0;
+}
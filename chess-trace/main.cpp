@@ -0,0 +1,150 @@
+#include "trace-recorder.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using ChessSimulator::MCTS_TraceEvent;
+using ChessSimulator::MCTS_TraceRecord;
+
+struct ThreadRecord {
+    std::uint32_t thread;
+    MCTS_TraceRecord record;
+};
+
+static const char *eventName(MCTS_TraceEvent type) {
+    switch (type) {
+    case MCTS_TraceEvent::CYCLE_BEGIN:
+        return "cycle-begin";
+    case MCTS_TraceEvent::SELECT:
+        return "select";
+    case MCTS_TraceEvent::EXPAND:
+        return "expand";
+    case MCTS_TraceEvent::PLAYOUT:
+        return "playout";
+    case MCTS_TraceEvent::CYCLE_END:
+        return "cycle-end";
+    }
+    return "unknown";
+}
+
+// Read every chunk of a trace file, ordered by time
+static bool readTrace(const std::string &path, std::vector<ThreadRecord> &records, std::map<std::uint32_t, std::uint64_t> &dropped) {
+    std::ifstream file(path, std::ios::binary);
+    std::uint32_t header[2] = {};
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!file || header[0] != ChessSimulator::MCTS_TRACE_MAGIC || header[1] != ChessSimulator::MCTS_TRACE_VERSION) {
+        return false;
+    }
+
+    ChessSimulator::MCTS_TraceChunk chunk;
+    while (file.read(reinterpret_cast<char *>(&chunk), sizeof(chunk))) {
+        std::vector<MCTS_TraceRecord> chunkRecords(chunk.count);
+        file.read(reinterpret_cast<char *>(chunkRecords.data()), chunk.count * sizeof(MCTS_TraceRecord));
+        for (auto const &record : chunkRecords) {
+            records.push_back({chunk.threadId, record});
+        }
+        dropped[chunk.threadId] = std::max(dropped[chunk.threadId], chunk.dropped);
+    }
+
+    std::stable_sort(records.begin(), records.end(),
+                     [](const ThreadRecord &a, const ThreadRecord &b) { return a.record.time < b.record.time; });
+    return true;
+}
+
+static void summarise(const std::vector<ThreadRecord> &records, const std::map<std::uint32_t, std::uint64_t> &dropped) {
+    long long cycles = 0, expansions = 0, children = 0, playouts = 0, plies = 0;
+    long long wins = 0, draws = 0, losses = 0;
+    long long pathNodes = 0;
+    double cycleTime = 0, maxCycleTime = 0;
+    std::map<std::uint32_t, std::uint64_t> cycleStart;
+
+    for (auto const &[thread, record] : records) {
+        switch (record.type) {
+        case MCTS_TraceEvent::CYCLE_BEGIN:
+            cycles++;
+            cycleStart[thread] = record.time;
+            break;
+        case MCTS_TraceEvent::CYCLE_END:
+            if (cycleStart.count(thread)) {
+                double duration = (record.time - cycleStart[thread]) / 1000.0;
+                cycleTime += duration;
+                maxCycleTime = std::max(maxCycleTime, duration);
+            }
+            break;
+        case MCTS_TraceEvent::SELECT:
+            pathNodes++;
+            break;
+        case MCTS_TraceEvent::EXPAND:
+            expansions++;
+            children += record.arg;
+            break;
+        case MCTS_TraceEvent::PLAYOUT:
+            playouts++;
+            plies += record.arg;
+            if (record.result > 0)
+                wins++;
+            else if (record.result < 0)
+                losses++;
+            else
+                draws++;
+            break;
+        }
+    }
+
+    std::uint64_t totalDropped = 0;
+    for (auto const &entry : dropped) {
+        totalDropped += entry.second;
+    }
+
+    double span = records.empty() ? 0 : (records.back().record.time - records.front().record.time) / 1e9;
+    std::printf("events      %zu over %.3fs from %zu threads, %llu dropped\n", records.size(), span, dropped.size(),
+                (unsigned long long)totalDropped);
+    std::printf("cycles      %lld, %.1f us avg, %.1f us max\n", cycles, cycles ? cycleTime / cycles : 0.0, maxCycleTime);
+    std::printf("selection   %.2f nodes per path\n", cycles ? (double)pathNodes / cycles : 0.0);
+    std::printf("expansions  %lld, %.1f children avg\n", expansions, expansions ? (double)children / expansions : 0.0);
+    std::printf("playouts    %lld, %.1f plies avg, %lld won / %lld drawn / %lld lost for the root\n", playouts,
+                playouts ? (double)plies / playouts : 0.0, wins, draws, losses);
+}
+
+// Print every event in the order it happened
+static void replay(const std::vector<ThreadRecord> &records) {
+    std::uint64_t start = records.empty() ? 0 : records.front().record.time;
+    for (auto const &[thread, record] : records) {
+        std::printf("%12.3f us  t%-2u %-12s node %-6u", (record.time - start) / 1000.0, thread, eventName(record.type),
+                    record.node);
+        if (record.type == MCTS_TraceEvent::SELECT) {
+            std::printf(" depth %u", record.arg);
+        } else if (record.type == MCTS_TraceEvent::EXPAND) {
+            std::printf(" children %u", record.arg);
+        } else if (record.type == MCTS_TraceEvent::PLAYOUT) {
+            std::printf(" plies %u result %.2f", record.arg, record.result / 100.0);
+        }
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::printf("usage: chesstrace <trace file> [summary|replay]\n");
+        return 1;
+    }
+
+    std::vector<ThreadRecord> records;
+    std::map<std::uint32_t, std::uint64_t> dropped;
+    if (!readTrace(argv[1], records, dropped)) {
+        std::printf("couldn't read trace %s\n", argv[1]);
+        return 1;
+    }
+
+    std::string mode = argc > 2 ? argv[2] : "summary";
+    if (mode == "replay") {
+        replay(records);
+    } else {
+        summarise(records, dropped);
+    }
+
+    return 0;
+}
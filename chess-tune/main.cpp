@@ -0,0 +1,234 @@
+#include "eval-weights.h"
+#include "training-data.h"
+#include "worker-pool.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Features are material (0-5), the piece-square tables (6 + type * 64 + square),
+// then doubled and isolated pawns and passed pawns by rank
+static constexpr int pawnFeatures = 6 + 6 * 64;
+static constexpr int featureCount = pawnFeatures + 2 + 8;
+// Set on entries of black pieces, which count against white
+static constexpr std::uint16_t blackFeature = 0x8000;
+
+// Positions as rows of active features, stored back to back so an epoch streams through memory once
+struct FeatureMatrix {
+    std::vector<std::uint32_t> offsets = {0};
+    std::vector<std::uint16_t> entries;
+    std::vector<float> targets;
+
+    int rows() const { return targets.size(); }
+};
+
+// Add a shard's positions with targets from white's point of view, blending
+// the game result with the search value by lambda
+static bool loadShard(const std::string &path, float lambda, FeatureMatrix &matrix) {
+    ChessSimulator::TrainingDataReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+
+    ChessSimulator::TrainingRecord record;
+    int squares[32];
+    int pieces[32];
+    while (reader.next(record)) {
+        std::uint64_t pawns[2] = {};
+        int count = ChessSimulator::unpackPieces(record.position, squares, pieces);
+        for (int i = 0; i < count; i++) {
+            if (pieces[i] % 6 == 0) {
+                pawns[pieces[i] / 6] |= 1ull << squares[i];
+            }
+
+            int type = pieces[i] % 6;
+            bool black = pieces[i] >= 6;
+            int square = black ? squares[i] ^ 56 : squares[i];
+            std::uint16_t sign = black ? blackFeature : 0;
+
+            // Kings always cancel out, only their placement matters
+            if (type != 5) {
+                matrix.entries.push_back(type | sign);
+            }
+            matrix.entries.push_back((6 + type * 64 + square) | sign);
+        }
+
+        // Pawn structure counts repeat their feature, black's seen from its own side
+        for (int side = 0; side < 2; side++) {
+            auto counts = side == 0 ? ChessSimulator::EvalWeights::countPawns(pawns[0], pawns[1])
+                                    : ChessSimulator::EvalWeights::countPawns(std::byteswap(pawns[1]), std::byteswap(pawns[0]));
+            std::uint16_t sign = side == 0 ? 0 : blackFeature;
+            matrix.entries.insert(matrix.entries.end(), counts.doubled, pawnFeatures | sign);
+            matrix.entries.insert(matrix.entries.end(), counts.isolated, (pawnFeatures + 1) | sign);
+            for (int rank = 0; rank < 8; rank++) {
+                matrix.entries.insert(matrix.entries.end(), counts.passed[rank], (pawnFeatures + 2 + rank) | sign);
+            }
+        }
+        matrix.offsets.push_back(matrix.entries.size());
+
+        float result = (record.position.result + 1) / 2.0f;
+        float value = (record.position.value / 32767.0f + 1) / 2.0f;
+        float target = lambda * result + (1 - lambda) * value;
+        bool blackToMove = record.position.flags & 1;
+        matrix.targets.push_back(blackToMove ? 1 - target : target);
+    }
+
+    return true;
+}
+
+// Accumulate the log loss and its gradient over a slice of the positions
+static double lossGradient(const FeatureMatrix &matrix, const std::vector<float> &weights, float scale, int begin,
+                           int end, std::vector<double> &gradient) {
+    double loss = 0;
+    for (int row = begin; row < end; row++) {
+        float eval = 0;
+        for (std::uint32_t i = matrix.offsets[row]; i < matrix.offsets[row + 1]; i++) {
+            std::uint16_t entry = matrix.entries[i];
+            float weight = weights[entry & ~blackFeature];
+            eval += entry & blackFeature ? -weight : weight;
+        }
+
+        float target = matrix.targets[row];
+        float p = std::clamp(1 / (1 + std::exp(-eval / scale)), 1e-6f, 1 - 1e-6f);
+        loss -= target * std::log(p) + (1 - target) * std::log(1 - p);
+
+        double g = (p - target) / scale;
+        for (std::uint32_t i = matrix.offsets[row]; i < matrix.offsets[row + 1]; i++) {
+            std::uint16_t entry = matrix.entries[i];
+            gradient[entry & ~blackFeature] += entry & blackFeature ? -g : g;
+        }
+    }
+
+    return loss;
+}
+
+int main(int argc, char *argv[]) {
+    std::string output;
+    std::string initial;
+    std::vector<std::string> shards;
+    int epochs = 500;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    float rate = 2.0f;
+    float lambda = 1.0f;
+    float scale = 400.0f;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--epochs" && i + 1 < argc) {
+            epochs = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            rate = std::stof(argv[++i]);
+        } else if (arg == "--lambda" && i + 1 < argc) {
+            lambda = std::stof(argv[++i]);
+        } else if (arg == "--scale" && i + 1 < argc) {
+            scale = std::stof(argv[++i]);
+        } else if (arg == "--init" && i + 1 < argc) {
+            initial = argv[++i];
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            shards.push_back(arg);
+        }
+    }
+
+    if (output.empty() || shards.empty()) {
+        std::printf("usage: chesstune <output .bin|.h> <shards...> [--epochs N] [--threads N] [--rate R] "
+                    "[--lambda L] [--scale K] [--init weights.bin]\n");
+        return 1;
+    }
+
+    ChessSimulator::EvalWeights evalWeights;
+    if (!initial.empty() && !evalWeights.load(initial)) {
+        std::printf("couldn't load weights %s\n", initial.c_str());
+        return 1;
+    }
+    evalWeights.scale = scale;
+
+    auto beforeTime = std::chrono::high_resolution_clock::now();
+    FeatureMatrix matrix;
+    for (auto const &shard : shards) {
+        if (!loadShard(shard, lambda, matrix)) {
+            std::printf("couldn't read %s\n", shard.c_str());
+            return 1;
+        }
+    }
+    auto loadTime = std::chrono::high_resolution_clock::now();
+    std::printf("loaded %d positions (%zu features) in %.2fs\n", matrix.rows(), matrix.entries.size(),
+                std::chrono::duration<double>(loadTime - beforeTime).count());
+    if (matrix.rows() == 0) {
+        return 1;
+    }
+
+    std::vector<float> weights(featureCount);
+    std::copy(evalWeights.material, evalWeights.material + 6, weights.begin());
+    std::copy(&evalWeights.pieceSquare[0][0], &evalWeights.pieceSquare[0][0] + 6 * 64, weights.begin() + 6);
+    weights[pawnFeatures] = evalWeights.doubledPawn;
+    weights[pawnFeatures + 1] = evalWeights.isolatedPawn;
+    std::copy(evalWeights.passedPawn, evalWeights.passedPawn + 8, weights.begin() + pawnFeatures + 2);
+
+    // Adam over the full batch, each task sums the gradient of its own slice
+    ChessSimulator::MCTS_WorkerPool pool(threads);
+    int tasks = threads * 4;
+    std::vector<std::vector<double>> gradients(tasks, std::vector<double>(featureCount));
+    std::vector<double> losses(tasks);
+    std::vector<double> m(featureCount), v(featureCount);
+    const double beta1 = 0.9, beta2 = 0.999;
+
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        pool.run(tasks, [&](int task, int worker) {
+            int begin = static_cast<long long>(matrix.rows()) * task / tasks;
+            int end = static_cast<long long>(matrix.rows()) * (task + 1) / tasks;
+            std::fill(gradients[task].begin(), gradients[task].end(), 0.0);
+            losses[task] = lossGradient(matrix, weights, scale, begin, end, gradients[task]);
+        });
+
+        double loss = 0;
+        for (int task = 0; task < tasks; task++) {
+            loss += losses[task];
+        }
+
+        for (int f = 0; f < featureCount; f++) {
+            double g = 0;
+            for (int task = 0; task < tasks; task++) {
+                g += gradients[task][f];
+            }
+            g /= matrix.rows();
+
+            m[f] = beta1 * m[f] + (1 - beta1) * g;
+            v[f] = beta2 * v[f] + (1 - beta2) * g * g;
+            double mHat = m[f] / (1 - std::pow(beta1, epoch));
+            double vHat = v[f] / (1 - std::pow(beta2, epoch));
+            weights[f] -= rate * mHat / (std::sqrt(vHat) + 1e-8);
+        }
+
+        if (epoch == 1 || epoch % 50 == 0 || epoch == epochs) {
+            std::printf("epoch %4d  loss %.6f\n", epoch, loss / matrix.rows());
+        }
+    }
+
+    auto afterTime = std::chrono::high_resolution_clock::now();
+    std::printf("tuned in %.2fs\n", std::chrono::duration<double>(afterTime - loadTime).count());
+
+    std::copy(weights.begin(), weights.begin() + 6, evalWeights.material);
+    std::copy(weights.begin() + 6, weights.begin() + pawnFeatures, &evalWeights.pieceSquare[0][0]);
+    evalWeights.doubledPawn = weights[pawnFeatures];
+    evalWeights.isolatedPawn = weights[pawnFeatures + 1];
+    std::copy(weights.begin() + pawnFeatures + 2, weights.end(), evalWeights.passedPawn);
+
+    bool header = output.size() > 2 && output.substr(output.size() - 2) == ".h";
+    bool saved = header ? evalWeights.saveHeader(output, "tunedEvalWeights") : evalWeights.save(output);
+    if (!saved) {
+        std::printf("couldn't write %s\n", output.c_str());
+        return 1;
+    }
+
+    std::printf("wrote %s\n", output.c_str());
+    return 0;
+}